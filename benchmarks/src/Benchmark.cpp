@@ -0,0 +1,61 @@
+#include "Benchmark.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+void BenchmarkRunner::record(const Result& result)
+{
+    results.push_back(result);
+    cout << left << setw(56) << result.name
+        << right << setw(16) << fixed << setprecision(1) << result.nanosecondsPerIteration << " ns/iter"
+        << setw(10) << result.iterations << " iters" << endl;
+}
+
+bool BenchmarkRunner::check(bool passed, const string& description)
+{
+    if(!passed) {
+        failures++;
+        cout << "FAILED: " << description << endl;
+    }
+    return passed;
+}
+
+bool BenchmarkRunner::writeJson(const string& path) const
+{
+    ofstream out(path);
+    if(!out) {
+        return false;
+    }
+    out << "[\n" << fixed << setprecision(1);
+    for(size_t i = 0; i < results.size(); i++) {
+        // Benchmark names never contain quotes or backslashes, so they need no escaping.
+        out << "  { \"name\": \"" << results[i].name << "\", \"iterations\": " << results[i].iterations
+            << ", \"nsPerIteration\": " << results[i].nanosecondsPerIteration << " }"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+    return (bool)out;
+}
+
+vector<uint> BenchmarkRunner::getEntityScales() const
+{
+    vector<uint> scales;
+    for(uint entities : { 1000u, 10000u, 100000u, 1000000u }) {
+        if(entities <= maxEntities) {
+            scales.push_back(entities);
+        }
+    }
+    return scales;
+}
+
+BenchmarkRegistration::BenchmarkRegistration(const char* name, BenchmarkFunction fcn, bool isCheck)
+{
+    getRegisteredBenchmarks().push_back({ name, fcn, isCheck });
+}
+
+vector<RegisteredBenchmark>& getRegisteredBenchmarks()
+{
+    static vector<RegisteredBenchmark> benchmarks;
+    return benchmarks;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "std.h"
+
+#include <chrono>
+
+class BenchmarkRunner
+{
+public:
+    struct Result
+    {
+        string name;
+        uint iterations;
+        double nanosecondsPerIteration;
+    };
+
+    /*
+    Calls fcn iterations times and records the average time per call under name.
+    Any setup should happen before calling measure so that it is not timed.
+    */
+    template<typename F>
+    void measure(const string& name, uint iterations, F fcn)
+    {
+        // One untimed call to warm up caches and lazily allocated storage.
+        fcn();
+        auto start = chrono::high_resolution_clock::now();
+        for(uint i = 0; i < iterations; i++) {
+            fcn();
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double ns = (double)chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+        record({ name, iterations, ns / iterations });
+    }
+
+    /*
+    Records a failure under description unless passed, for checks. Returns passed.
+    Checks use this to verify that optimised code paths agree with the reference ones.
+    */
+    bool check(bool passed, const string& description);
+    // The number of failed calls to check.
+    inline uint getFailures() const { return failures; }
+
+    inline const vector<Result>& getResults() const { return results; }
+    // Writes the results as a JSON array of { "name", "iterations", "nsPerIteration" } objects.
+    bool writeJson(const string& path) const;
+
+    // The entity counts that scaling benchmarks run at: 1k, 10k, 100k and 1M, up to maxEntities.
+    vector<uint> getEntityScales() const;
+    // The number of iterations that adds up to about totalEntities entities of work, and at least one.
+    static inline uint iterationsFor(uint entities, uint totalEntities = 1000000) {
+        return entities < totalEntities ? totalEntities / entities : 1;
+    }
+
+    // The largest entity count to run scaling benchmarks at. Set with --max-entities.
+    uint maxEntities = 1000000;
+private:
+    void record(const Result& result);
+
+    vector<Result> results;
+    uint failures = 0;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkRunner& runner);
+
+// Adds a benchmark or check to the global list. Use the BENCHMARK and BENCHMARK_CHECK macros rather than this.
+struct BenchmarkRegistration
+{
+    BenchmarkRegistration(const char* name, BenchmarkFunction fcn, bool isCheck = false);
+};
+
+struct RegisteredBenchmark
+{
+    const char* name;
+    BenchmarkFunction fcn;
+    bool isCheck; // Checks only run with --check, and benchmarks only without it.
+};
+
+vector<RegisteredBenchmark>& getRegisteredBenchmarks();
+
+// Prevents the compiler from optimising away a (scalar) value computed by a benchmark.
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    // An empty asm block that claims to read the value and clobber memory, so the value must be computed.
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile T sink;
+    sink = value;
+    (void)sink;
+#endif
+}
+
+#define BENCHMARK(name) \
+    static void name(BenchmarkRunner& runner); \
+    static BenchmarkRegistration name##Registration(#name, name); \
+    static void name(BenchmarkRunner& runner)
+
+// Like BENCHMARK, but for a correctness check that calls runner.check rather than measuring anything.
+#define BENCHMARK_CHECK(name) \
+    static void name(BenchmarkRunner& runner); \
+    static BenchmarkRegistration name##Registration(#name, name, true); \
+    static void name(BenchmarkRunner& runner)
@@ -0,0 +1,54 @@
+#include "Benchmark.h"
+
+#include "core/JobSystem.h"
+
+#include <cmath>
+
+// The thread counts to measure: powers of two up to every hardware thread, and every hardware thread.
+static vector<uint> getThreadCounts()
+{
+    uint maxThreads = JobSystem::getDefaultWorkerCount() + 1;
+    vector<uint> counts;
+    for(uint threads = 1; threads < maxThreads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+// The cost of submitting a batch of 10000 empty jobs and waiting for them.
+BENCHMARK(JobOverhead)
+{
+    const uint batch = 10000;
+    for(uint threads : getThreadCounts()) {
+        JobSystem jobs(threads - 1);
+        runner.measure("JobOverhead/threads:" + to_string(threads) + "/batch:10000", 100, [&jobs]() {
+            JobCounter counter;
+            for(uint i = 0; i < batch; i++) {
+                jobs.submit([]() {}, &counter);
+            }
+            jobs.wait(counter);
+        });
+    }
+}
+
+// A compute-bound loop split across 1 to N threads. The caller counts as one of the threads.
+BENCHMARK(ParallelForScaling)
+{
+    const size_t count = 1 << 22;
+    vector<float> values(count);
+    for(size_t i = 0; i < count; i++) {
+        values[i] = (float)i;
+    }
+    for(uint threads : getThreadCounts()) {
+        JobSystem jobs(threads - 1);
+        runner.measure("ParallelForScaling/threads:" + to_string(threads), 20, [&]() {
+            jobs.parallelFor(count, 0, [&values](size_t first, size_t last) {
+                for(size_t i = first; i < last; i++) {
+                    values[i] = sqrt(values[i] * values[i] + 1.0f);
+                }
+            });
+        });
+    }
+    doNotOptimize(values[count / 2]);
+}
@@ -0,0 +1,190 @@
+#include "Benchmark.h"
+
+#include "core/World.h"
+#include "core/Entity.h"
+#include "core/Component.h"
+#include "core/Query.h"
+#include "core/LazyQuery.h"
+
+/*
+Stand-ins for the components used by GravitySystem in main.cpp, so the same query chain can be
+measured without Bullet.
+*/
+
+class BenchBody : public Component
+{
+public:
+    BenchBody() : Component(get_id(BenchBody)) {}
+
+    float mass = 1;
+    vec3 force = vec3(0, 0, 0);
+};
+
+class BenchApplyGravity : public Component
+{
+public:
+    BenchApplyGravity() : Component(get_id(BenchApplyGravity)) {}
+};
+
+class BenchRegion : public Component
+{
+public:
+    BenchRegion() : Component(get_id(BenchRegion)) {}
+
+    vector<Handle<BenchBody>> overlaps;
+
+    // Mirrors Trigger::getOverlaps.
+    vector<shared_ptr<BenchBody>> getOverlaps() {
+        vector<shared_ptr<BenchBody>> result;
+        for(Handle<BenchBody>& overlap : overlaps) {
+            BenchBody* body = overlap.get();
+            if(body) {
+                result.push_back(static_pointer_cast<BenchBody>(body->shared_from_this()));
+            }
+        }
+        return result;
+    }
+    inline const vector<Handle<BenchBody>>& getOverlapHandles() const { return overlaps; }
+};
+
+// Builds a world of bodies where every other body applies gravity and every third body is in the region.
+static shared_ptr<World> buildGravityWorld(uint bodies)
+{
+    shared_ptr<World> world = make_shared<World>();
+    shared_ptr<Entity> regionEntity = world->addEntity();
+    shared_ptr<BenchRegion> region = regionEntity->addComponent<BenchRegion>();
+    for(uint i = 0; i < bodies; i++) {
+        shared_ptr<Entity> entity = world->addEntity();
+        shared_ptr<BenchBody> body = entity->addComponent<BenchBody>();
+        if(i % 2 == 0) {
+            entity->addComponent<BenchApplyGravity>();
+        }
+        if(i % 3 == 0) {
+            region->overlaps.push_back(body);
+        }
+    }
+    return world;
+}
+
+// The chain GravitySystem used before lazy queries existed.
+static void gravityWithQuery(World& world)
+{
+    auto regionQuery = world.queryComponents(get_id(BenchRegion))
+        .map_ptr<BenchRegion>(mapToSibling<BenchRegion>)
+        .map_group_ptr<BenchBody>([](shared_ptr<BenchRegion> r){ return r->getOverlaps(); });
+    auto bodyQuery = world.queryComponents(get_id(BenchApplyGravity))
+        .map_ptr<BenchBody>(mapToSibling<BenchBody>);
+    for(shared_ptr<BenchBody> body : bodyQuery) {
+        if(regionQuery.contains(body)) {
+            body->force += vec3(0, -10, 0) * body->mass;
+        }
+    }
+}
+
+// The same chain as a lazy pipeline.
+static void gravityWithLazyQuery(World& world)
+{
+    hash_set<BenchBody*> regionOverlaps;
+    lazyQuery(world.getComponentsOfType<BenchRegion>())
+        .map_group([](BenchRegion& region) -> const vector<Handle<BenchBody>>& {
+            return region.getOverlapHandles();
+        })
+        .map([](const Handle<BenchBody>& overlap) { return overlap.get(); })
+        .collect(regionOverlaps);
+    lazyQuery(world.getComponentsOfType<BenchApplyGravity>())
+        .map_ptr([](BenchApplyGravity& gravity) { return getSibling<BenchBody>(gravity); })
+        .filter([&regionOverlaps](BenchBody* body) { return regionOverlaps.count(body) > 0; })
+        .forEach([](BenchBody* body) { body->force += vec3(0, -10, 0) * body->mass; });
+}
+
+// The lazy chain with the sibling lookup replaced by an owner join.
+static void gravityWithOwnerJoin(World& world)
+{
+    hash_set<BenchBody*> regionOverlaps;
+    lazyQuery(world.getComponentsOfType<BenchRegion>())
+        .map_group([](BenchRegion& region) -> const vector<Handle<BenchBody>>& {
+            return region.getOverlapHandles();
+        })
+        .map([](const Handle<BenchBody>& overlap) { return overlap.get(); })
+        .collect(regionOverlaps);
+    lazyQuery(world.joinByOwner<BenchApplyGravity, BenchBody>())
+        .map([](pair<BenchApplyGravity*, BenchBody*> gravity) { return gravity.second; })
+        .filter([&regionOverlaps](BenchBody* body) { return regionOverlaps.count(body) > 0; })
+        .forEach([](BenchBody* body) { body->force += vec3(0, -10, 0) * body->mass; });
+}
+
+// Both joins as tuple views.
+static void gravityWithEach(World& world)
+{
+    hash_set<BenchBody*> regionOverlaps;
+    world.each<const BenchRegion>([&regionOverlaps](const BenchRegion& region) {
+        for(const Handle<BenchBody>& overlap : region.getOverlapHandles()) {
+            regionOverlaps.insert(overlap.get());
+        }
+    });
+    world.each<const BenchApplyGravity, BenchBody>([&regionOverlaps](const BenchApplyGravity&, BenchBody& body) {
+        if(regionOverlaps.count(&body) > 0) {
+            body.force += vec3(0, -10, 0) * body.mass;
+        }
+    });
+}
+
+BENCHMARK(GravityChain)
+{
+    for(uint bodies : runner.getEntityScales()) {
+        shared_ptr<World> world = buildGravityWorld(bodies);
+        uint iterations = BenchmarkRunner::iterationsFor(bodies);
+        runner.measure("GravityChain/Query/" + to_string(bodies), iterations,
+            [&world](){ gravityWithQuery(*world); });
+        runner.measure("GravityChain/LazyQuery/" + to_string(bodies), iterations,
+            [&world](){ gravityWithLazyQuery(*world); });
+        runner.measure("GravityChain/OwnerJoin/" + to_string(bodies), iterations,
+            [&world](){ gravityWithOwnerJoin(*world); });
+        runner.measure("GravityChain/Each/" + to_string(bodies), iterations,
+            [&world](){ gravityWithEach(*world); });
+    }
+}
+
+BENCHMARK(FilterMapChain)
+{
+    for(uint bodies : runner.getEntityScales()) {
+        shared_ptr<World> world = buildGravityWorld(bodies);
+        uint iterations = BenchmarkRunner::iterationsFor(bodies);
+        runner.measure("FilterMapChain/Query/" + to_string(bodies), iterations, [&world](){
+            auto query = world->queryComponents(get_id(BenchBody))
+                .filter([](shared_ptr<Component> c) { return static_pointer_cast<BenchBody>(c)->mass > 0; })
+                .cast_ptr<BenchBody>();
+            float sum = 0;
+            for(shared_ptr<BenchBody> body : query) {
+                sum += body->mass;
+            }
+            doNotOptimize(sum);
+        });
+        runner.measure("FilterMapChain/LazyQuery/" + to_string(bodies), iterations, [&world](){
+            float sum = 0;
+            lazyQuery(world->getComponentsOfType<BenchBody>())
+                .filter([](BenchBody& body) { return body.mass > 0; })
+                .map([](BenchBody& body) { return body.mass; })
+                .forEach([&sum](float mass) { sum += mass; });
+            doNotOptimize(sum);
+        });
+    }
+}
+
+BENCHMARK(QuerySetOps)
+{
+    for(uint bodies : runner.getEntityScales()) {
+        shared_ptr<World> world = buildGravityWorld(bodies);
+        uint iterations = BenchmarkRunner::iterationsFor(bodies);
+        Query<shared_ptr<Component>> all = world->queryComponents(get_id(BenchBody))
+            .map_ptr<Component>(mapToSibling<BenchBody>);
+        Query<shared_ptr<Component>> gravity = world->queryComponents(get_id(BenchApplyGravity))
+            .map_ptr<Component>(mapToSibling<BenchBody>);
+        runner.measure("QuerySetOps/Intersect/" + to_string(bodies), iterations, [&](){
+            doNotOptimize((all & gravity).size());
+        });
+        runner.measure("QuerySetOps/Difference/" + to_string(bodies), iterations, [&](){
+            doNotOptimize((all - gravity).size());
+        });
+    }
+}
@@ -0,0 +1,289 @@
+#include "Benchmark.h"
+
+#include "components/Transform.h"
+#include "core/TransformHierarchy.h"
+#include "core/TransformKernels.h"
+
+#include <random>
+
+// Computing the global transform of every transform in chains of parents of different depths.
+BENCHMARK(GlobalTransform)
+{
+    for(uint depth : { 1u, 4u, 16u, 64u }) {
+        for(uint count : runner.getEntityScales()) {
+            vector<shared_ptr<Transform>> transforms;
+            transforms.reserve(count);
+            for(uint i = 0; i < count; i++) {
+                shared_ptr<Transform> transform = make_shared<Transform>();
+                transform->setRelativeTransform(TransformData(vec3(1, 0, 0)));
+                if(i % depth != 0) {
+                    transform->setParent(transforms.back().get(), false);
+                }
+                transforms.push_back(transform);
+            }
+            runner.measure("GlobalTransform/depth:" + to_string(depth) + "/" + to_string(count),
+                BenchmarkRunner::iterationsFor(count, 100000), [&transforms]() {
+                    float sum = 0;
+                    for(const shared_ptr<Transform>& transform : transforms) {
+                        sum += transform->getGlobalTransform().translation.x;
+                    }
+                    doNotOptimize(sum);
+                });
+        }
+    }
+}
+
+// Moving every root of 100k nodes in chains of different depths, then reading every world matrix.
+BENCHMARK(TransformUpdate)
+{
+    uint count = std::min(100000u, runner.maxEntities);
+    JobSystem jobs;
+    for(uint depth : { 1u, 4u, 16u }) {
+        string suffix = "/depth:" + to_string(depth) + "/" + to_string(count);
+
+        vector<shared_ptr<Transform>> transforms;
+        vector<Transform*> roots;
+        transforms.reserve(count);
+        for(uint i = 0; i < count; i++) {
+            shared_ptr<Transform> transform = make_shared<Transform>();
+            transform->setRelativeTransform(TransformData(vec3(1, 0, 0)));
+            if(i % depth != 0) {
+                transform->setParent(transforms.back().get(), false);
+            } else {
+                roots.push_back(transform.get());
+            }
+            transforms.push_back(transform);
+        }
+        float offset = 0;
+        runner.measure("TransformUpdate/components" + suffix, 10, [&transforms, &roots, &offset]() {
+            offset += 1;
+            for(Transform* root : roots) {
+                root->setRelativeTransform(TransformData(vec3(offset, 0, 0)));
+            }
+            float sum = 0;
+            for(const shared_ptr<Transform>& transform : transforms) {
+                sum += transform->getGlobalMatrix()[3].x;
+            }
+            doNotOptimize(sum);
+        });
+        transforms.clear();
+
+        TransformHierarchy hierarchy;
+        vector<uint> nodes;
+        vector<uint> rootNodes;
+        nodes.reserve(count);
+        for(uint i = 0; i < count; i++) {
+            uint parent = i % depth != 0 ? nodes.back() : TransformHierarchy::NO_PARENT;
+            nodes.push_back(hierarchy.addNode(TransformData(vec3(1, 0, 0)), parent));
+            if(parent == TransformHierarchy::NO_PARENT) {
+                rootNodes.push_back(nodes.back());
+            }
+        }
+        hierarchy.update();
+        for(JobSystem* jobSystem : { (JobSystem*)nullptr, &jobs }) {
+            runner.measure(string("TransformUpdate/hierarchy") + (jobSystem ? "-jobs" : "") + suffix, 10,
+                [&hierarchy, &nodes, &rootNodes, &offset, jobSystem]() {
+                    offset += 1;
+                    for(uint root : rootNodes) {
+                        hierarchy.setLocalTransform(root, TransformData(vec3(offset, 0, 0)));
+                    }
+                    hierarchy.update(jobSystem);
+                    float sum = 0;
+                    for(uint node : nodes) {
+                        sum += hierarchy.getWorldMatrix(node)[3].x;
+                    }
+                    doNotOptimize(sum);
+                });
+        }
+    }
+}
+
+// Whether every float agrees to within float rounding, relative to the larger magnitude.
+static bool nearlyEqual(const float* actual, const float* expected, size_t count)
+{
+    for(size_t i = 0; i < count; i++) {
+        float tolerance = 1e-5f * std::max(1.0f, std::max(std::abs(actual[i]), std::abs(expected[i])));
+        if(!(std::abs(actual[i] - expected[i]) <= tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+static bool nearlyEqual(const vector<T>& actual, const vector<T>& expected)
+{
+    return actual.size() == expected.size() && nearlyEqual((const float*)actual.data(), (const float*)expected.data(),
+        actual.size() * sizeof(T) / sizeof(float));
+}
+
+// Copies the transforms into per-float arrays, and returns the arrays.
+static TransformArrays toArrays(const vector<TransformData>& transforms, vector<float> (&fields)[TRANSFORM_FIELDS])
+{
+    TransformArrays arrays;
+    for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+        fields[field].assign(transforms.size(), 0.0f);
+        arrays.fields[field] = fields[field].data();
+    }
+    for(size_t i = 0; i < transforms.size(); i++) {
+        arrays.set(i, transforms[i]);
+    }
+    return arrays;
+}
+
+static vector<TransformData> fromArrays(const ConstTransformArrays& arrays, size_t count)
+{
+    vector<TransformData> transforms;
+    for(size_t i = 0; i < count; i++) {
+        transforms.push_back(arrays.get(i));
+    }
+    return transforms;
+}
+
+// The batch transform kernels over arrays of transforms, at every instruction set this machine supports.
+BENCHMARK(TransformKernels)
+{
+    SimdLevel supported = getSupportedSimdLevel();
+    for(SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if(!setSimdLevel(level)) {
+            continue;
+        }
+        for(uint count : runner.getEntityScales()) {
+            vector<TransformData> transforms(count, TransformData(vec3(1, 2, 3), angleAxis(0.5f, vec3(0, 1, 0)), vec3(2)));
+            vector<TransformData> out(count);
+            vector<mat4> matrices(count);
+            vector<vec3> points(count, vec3(1, 0, 0));
+            vector<vec3> movedPoints(count);
+            vector<float> fields[TRANSFORM_FIELDS];
+            vector<float> outFields[TRANSFORM_FIELDS];
+            TransformArrays arrays = toArrays(transforms, fields);
+            TransformArrays outArrays = toArrays(out, outFields);
+            string suffix = "/" + to_string(level) + "/" + to_string(count);
+            uint iterations = BenchmarkRunner::iterationsFor(count, 10000000);
+
+            runner.measure("TransformKernels/compose" + suffix, iterations, [&transforms, &out, count]() {
+                composeTransforms(transforms.data(), transforms.data(), out.data(), count);
+                doNotOptimize(out[count - 1].translation.x);
+            });
+            runner.measure("TransformKernels/composeArrays" + suffix, iterations, [&arrays, &outArrays, count]() {
+                composeTransforms(arrays, arrays, outArrays, count);
+                doNotOptimize(outArrays.fields[0][count - 1]);
+            });
+            runner.measure("TransformKernels/invert" + suffix, iterations, [&transforms, &out, count]() {
+                invertTransforms(transforms.data(), out.data(), count);
+                doNotOptimize(out[count - 1].translation.x);
+            });
+            runner.measure("TransformKernels/toMat4" + suffix, iterations, [&transforms, &matrices, count]() {
+                transformsToMat4(transforms.data(), matrices.data(), count);
+                doNotOptimize(matrices[count - 1][3].x);
+            });
+            runner.measure("TransformKernels/points" + suffix, iterations, [&transforms, &points, &movedPoints, count]() {
+                transformPoints(transforms[0], points.data(), movedPoints.data(), count);
+                doNotOptimize(movedPoints[count - 1].x);
+            });
+        }
+    }
+    setSimdLevel(supported);
+}
+
+// Every batch kernel, at every instruction set this machine supports, against the scalar TransformData functions.
+BENCHMARK_CHECK(TransformKernelsMatchScalar)
+{
+    mt19937 random(12345);
+    uniform_real_distribution<float> value(-4.0f, 4.0f);
+    auto randomTransform = [&random, &value]() {
+        quat rotation = angleAxis(value(random), normalize(vec3(value(random), value(random), value(random))));
+        return TransformData(vec3(value(random), value(random), value(random)), rotation,
+            vec3(value(random), value(random), value(random)));
+    };
+
+    SimdLevel supported = getSupportedSimdLevel();
+    for(SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if(!setSimdLevel(level)) {
+            continue;
+        }
+        // Counts around every vector width, so the scalar tails are covered too.
+        for(size_t count : { 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 100 }) {
+            string suffix = " (" + to_string(level) + ", " + to_string(count) + " transforms)";
+            vector<TransformData> lhs, rhs;
+            vector<vec3> points;
+            vector<uint> indices;
+            for(size_t i = 0; i < count; i++) {
+                lhs.push_back(randomTransform());
+                rhs.push_back(randomTransform());
+                points.push_back(vec3(value(random), value(random), value(random)));
+                indices.push_back((uint)(random() % count));
+            }
+            // Zero scales invert to zero.
+            lhs[count / 2].scale.y = 0.0f;
+
+            vector<TransformData> composed, indexed, inverted;
+            vector<mat4> matrices;
+            vector<vec3> moved;
+            for(size_t i = 0; i < count; i++) {
+                composed.push_back(lhs[i] * rhs[i]);
+                indexed.push_back(lhs[indices[i]] * rhs[i]);
+                inverted.push_back(lhs[i].inverse());
+                matrices.push_back(lhs[i].toMat4());
+                moved.push_back(lhs[0].transformPoint(points[i]));
+            }
+
+            vector<TransformData> out(count);
+            composeTransforms(lhs.data(), rhs.data(), out.data(), count);
+            runner.check(nearlyEqual(out, composed), "composeTransforms" + suffix);
+            out = lhs;
+            composeTransforms(out.data(), rhs.data(), out.data(), count);
+            runner.check(nearlyEqual(out, composed), "composeTransforms in place" + suffix);
+            invertTransforms(lhs.data(), out.data(), count);
+            runner.check(nearlyEqual(out, inverted), "invertTransforms" + suffix);
+            vector<mat4> outMatrices(count);
+            transformsToMat4(lhs.data(), outMatrices.data(), count);
+            runner.check(nearlyEqual(outMatrices, matrices), "transformsToMat4" + suffix);
+            vector<vec3> outPoints(count);
+            transformPoints(lhs[0], points.data(), outPoints.data(), count);
+            runner.check(nearlyEqual(outPoints, moved), "transformPoints" + suffix);
+
+            vector<float> lhsFields[TRANSFORM_FIELDS], rhsFields[TRANSFORM_FIELDS], outFields[TRANSFORM_FIELDS];
+            TransformArrays lhsArrays = toArrays(lhs, lhsFields);
+            TransformArrays rhsArrays = toArrays(rhs, rhsFields);
+            TransformArrays outArrays = toArrays(vector<TransformData>(count), outFields);
+            composeTransforms(lhsArrays, rhsArrays, outArrays, count);
+            runner.check(nearlyEqual(fromArrays(outArrays, count), composed), "composeTransforms on arrays" + suffix);
+            composeTransforms(lhsArrays, indices.data(), rhsArrays, outArrays, count);
+            runner.check(nearlyEqual(fromArrays(outArrays, count), indexed), "indexed composeTransforms" + suffix);
+            composeTransforms(lhsArrays, indices.data(), rhsArrays, rhsArrays, count);
+            runner.check(nearlyEqual(fromArrays(rhsArrays, count), indexed),
+                "indexed composeTransforms in place" + suffix);
+            transformsToMat4(lhsArrays, outMatrices.data(), count);
+            runner.check(nearlyEqual(outMatrices, matrices), "transformsToMat4 on arrays" + suffix);
+        }
+    }
+    setSimdLevel(supported);
+}
+
+// Reparenting onto a descendant attaches to the world instead, and other reparents keep the depths up to date.
+BENCHMARK_CHECK(TransformReparenting)
+{
+    shared_ptr<Transform> root = make_shared<Transform>();
+    shared_ptr<Transform> a = make_shared<Transform>();
+    shared_ptr<Transform> c = make_shared<Transform>();
+    for(Transform* transform : { root.get(), a.get(), c.get() }) {
+        transform->setRelativeTransform(TransformData(vec3(1, 0, 0)));
+    }
+    a->setParent(root.get(), false);
+    c->setParent(a.get(), false);
+    runner.check(c->getDepth() == 2 && c->getGlobalTransform().translation.x == 3.0f, "Chain of three transforms");
+
+    a->setParent(c.get(), false);
+    runner.check(a->getParent() == nullptr && a->getDepth() == 0, "Reparenting onto a child attaches to the world");
+    runner.check(c->getParent() == a.get() && c->getDepth() == 1, "The child keeps its parent");
+    runner.check(c->getGlobalTransform().translation.x == 2.0f, "The child moves with its former grandparent");
+
+    a->setParent(a.get(), false);
+    runner.check(a->getParent() == nullptr, "Reparenting onto itself attaches to the world");
+
+    c->setParent(root.get(), false);
+    a->setParent(c.get(), false);
+    runner.check(a->getParent() == c.get() && a->getDepth() == 2, "Reparenting onto a former child");
+    runner.check(a->getGlobalTransform().translation.x == 3.0f, "The reparented transform moves with its new parent");
+}
@@ -0,0 +1,241 @@
+#include "Benchmark.h"
+
+#include "core/Universe.h"
+#include "core/World.h"
+#include "core/System.h"
+#include "core/Entity.h"
+#include "core/Component.h"
+#include "core/Task.h"
+
+class SpawnPosition : public Component
+{
+public:
+    SpawnPosition() : Component(get_id(SpawnPosition)) {}
+
+    vec3 position = vec3(0, 0, 0);
+};
+
+class SpawnVelocity : public Component
+{
+public:
+    SpawnVelocity() : Component(get_id(SpawnVelocity)) {}
+
+    vec3 velocity = vec3(0, 0, 0);
+};
+
+class SpawnTag : public Component
+{
+public:
+    SpawnTag() : Component(get_id(SpawnTag)) {}
+};
+
+// Spawning entities with two components each, straight into the world and through a command buffer.
+BENCHMARK(SpawnEntities)
+{
+    for(uint entities : runner.getEntityScales()) {
+        uint iterations = BenchmarkRunner::iterationsFor(entities, 100000);
+        runner.measure("SpawnEntities/Direct/" + to_string(entities), iterations, [entities]() {
+            shared_ptr<World> world = make_shared<World>();
+            for(uint i = 0; i < entities; i++) {
+                shared_ptr<Entity> entity = world->addEntity();
+                entity->addComponent<SpawnPosition>();
+                entity->addComponent<SpawnVelocity>();
+            }
+        });
+        runner.measure("SpawnEntities/CommandBuffer/" + to_string(entities), iterations, [entities]() {
+            shared_ptr<World> world = make_shared<World>();
+            CommandBuffer& commands = world->getCommandBuffer();
+            for(uint i = 0; i < entities; i++) {
+                shared_ptr<Entity> entity = commands.spawnEntity();
+                entity->addComponent<SpawnPosition>();
+                entity->addComponent<SpawnVelocity>();
+            }
+            world->flushCommands();
+        });
+    }
+}
+
+// Tearing down a world of entities with two components each. The worlds are built before timing starts.
+BENCHMARK(DestroyWorld)
+{
+    for(uint entities : runner.getEntityScales()) {
+        uint iterations = BenchmarkRunner::iterationsFor(entities, 100000);
+        vector<shared_ptr<World>> worlds;
+        // One extra world for the warm-up call.
+        for(uint i = 0; i <= iterations; i++) {
+            shared_ptr<World> world = make_shared<World>();
+            for(uint j = 0; j < entities; j++) {
+                shared_ptr<Entity> entity = world->addEntity();
+                entity->addComponent<SpawnPosition>();
+                entity->addComponent<SpawnVelocity>();
+            }
+            worlds.push_back(world);
+        }
+        runner.measure("DestroyWorld/" + to_string(entities), iterations, [&worlds]() {
+            worlds.pop_back();
+        });
+    }
+}
+
+// Builds a world of entities with two components each.
+static shared_ptr<World> buildSpawnWorld(uint entities, vector<shared_ptr<Entity>>* spawned = nullptr)
+{
+    shared_ptr<World> world = make_shared<World>();
+    for(uint i = 0; i < entities; i++) {
+        shared_ptr<Entity> entity = world->addEntity();
+        entity->addComponent<SpawnPosition>();
+        entity->addComponent<SpawnVelocity>();
+        if(spawned) {
+            spawned->push_back(entity);
+        }
+    }
+    return world;
+}
+
+// Adding a component to every entity in a world, then removing it again.
+BENCHMARK(AddRemoveComponent)
+{
+    for(uint entities : runner.getEntityScales()) {
+        vector<shared_ptr<Entity>> spawned;
+        shared_ptr<World> world = buildSpawnWorld(entities, &spawned);
+        runner.measure("AddRemoveComponent/" + to_string(entities), BenchmarkRunner::iterationsFor(entities, 100000),
+            [&spawned]() {
+                for(const shared_ptr<Entity>& entity : spawned) {
+                    entity->addComponent<SpawnTag>();
+                }
+                for(const shared_ptr<Entity>& entity : spawned) {
+                    entity->removeComponent<SpawnTag>();
+                }
+            });
+    }
+}
+
+// Looking up a component by type on entities with two components each.
+BENCHMARK(FindComponent)
+{
+    for(uint entities : runner.getEntityScales()) {
+        vector<shared_ptr<Entity>> spawned;
+        shared_ptr<World> world = buildSpawnWorld(entities, &spawned);
+        uint iterations = BenchmarkRunner::iterationsFor(entities);
+        runner.measure("FindComponent/Shared/" + to_string(entities), iterations, [&spawned]() {
+            float sum = 0;
+            for(const shared_ptr<Entity>& entity : spawned) {
+                sum += entity->findComponent<SpawnVelocity>()->velocity.x;
+            }
+            doNotOptimize(sum);
+        });
+        runner.measure("FindComponent/Raw/" + to_string(entities), iterations, [&spawned]() {
+            float sum = 0;
+            for(const shared_ptr<Entity>& entity : spawned) {
+                sum += entity->getComponent<SpawnVelocity>()->velocity.x;
+            }
+            doNotOptimize(sum);
+        });
+    }
+}
+
+// Moves every entity with a position and velocity.
+class SpawnMoveSystem : public System
+{
+public:
+    SpawnMoveSystem() {
+        declareAccess({ get_id(SpawnVelocity) }, { get_id(SpawnPosition) });
+    }
+
+    virtual void gameplayTick(float delta) override {
+        getWorld()->each<SpawnPosition, const SpawnVelocity>(
+            [delta](SpawnPosition& position, const SpawnVelocity& velocity) {
+                position.position += velocity.velocity * delta;
+            });
+    }
+};
+
+// Ticking many independent worlds one after another and concurrently.
+BENCHMARK(ParallelWorlds)
+{
+    const uint worldCount = 16;
+    const uint entities = 10000;
+    for(bool parallel : { false, true }) {
+        Universe universe;
+        universe.parallelWorlds = parallel;
+        for(uint i = 0; i < worldCount; i++) {
+            shared_ptr<World> world = buildSpawnWorld(entities);
+            universe.addWorld(world);
+            world->addSystem<SpawnMoveSystem>();
+        }
+        // One gameplay tick per universe tick.
+        float delta = 1.0f / universe.gameplayRate;
+        runner.measure(string("ParallelWorlds/") + (parallel ? "Parallel/" : "Serial/") + to_string(worldCount),
+            20, [&universe, delta]() { universe.tick(delta); });
+    }
+}
+
+// Fast-forwarding a headless world of moving entities by 10 gameplay ticks per iteration.
+BENCHMARK(HeadlessTicks)
+{
+    for(uint entities : runner.getEntityScales()) {
+        Universe universe(0);
+        shared_ptr<World> world = universe.addWorld();
+        world->addSystem<SpawnMoveSystem>();
+        for(uint i = 0; i < entities; i++) {
+            shared_ptr<Entity> entity = world->addEntity();
+            entity->addComponent<SpawnPosition>();
+            entity->addComponent<SpawnVelocity>()->velocity = vec3(1, 0, 0);
+        }
+        runner.measure("HeadlessTicks/10/" + to_string(entities), BenchmarkRunner::iterationsFor(entities, 100000),
+            [&universe]() { universe.runTicks(10); });
+    }
+}
+
+class NoOpSystem : public System
+{
+public:
+    NoOpSystem() {
+        declareAccess({ get_id(SpawnPosition) }, {});
+    }
+};
+
+// The fixed cost of a Universe::tick (one gameplay and one frame tick) with many systems that do nothing.
+BENCHMARK(UniverseTick)
+{
+    for(uint systems : { 1u, 16u, 64u }) {
+        for(uint entities : runner.getEntityScales()) {
+            Universe universe;
+            shared_ptr<World> world = buildSpawnWorld(entities);
+            universe.addWorld(world);
+            for(uint i = 0; i < systems; i++) {
+                world->addSystem<NoOpSystem>();
+            }
+            float delta = 1.0f / universe.gameplayRate;
+            runner.measure("UniverseTick/systems:" + to_string(systems) + "/" + to_string(entities), 1000,
+                [&universe, delta]() { universe.tick(delta); });
+        }
+    }
+}
+
+// Alternates between waiting a tick and waiting on a timer, so every tick wakes half the tasks from each.
+static Task pacedTask(uint seed)
+{
+    while(true) {
+        co_await nextGameplayTick();
+        co_await ticks(1 + seed % 8);
+    }
+}
+
+// A gameplay tick of a world with no systems and many live tasks.
+BENCHMARK(TaskWakeups)
+{
+    for(uint tasks : runner.getEntityScales()) {
+        // Capped at 100k tasks to keep the run short, as in TransformUpdate.
+        if(tasks > 100000) {
+            break;
+        }
+        shared_ptr<World> world = make_shared<World>();
+        for(uint i = 0; i < tasks; i++) {
+            world->startTask(pacedTask(i));
+        }
+        world->gameplayTick(1.0f / 60.0f);
+        runner.measure("TaskWakeups/" + to_string(tasks), BenchmarkRunner::iterationsFor(tasks, 1000000),
+            [&world]() { world->gameplayTick(1.0f / 60.0f); });
+    }
+}
@@ -0,0 +1,58 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+/*
+Runs every registered benchmark, or only those whose name contains one of the filter arguments.
+    --json <path>          Also writes the results to path as JSON, for comparing runs.
+    --max-entities <n>     Skips entity counts above n in the scaling benchmarks (default 1000000).
+    --check                Runs the correctness checks instead, and exits with 1 if any of them fail.
+*/
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner;
+    vector<const char*> filters;
+    const char* jsonPath = nullptr;
+    bool checks = false;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if(strcmp(argv[i], "--max-entities") == 0 && i + 1 < argc) {
+            runner.maxEntities = (uint)strtoul(argv[++i], nullptr, 10);
+        } else if(strcmp(argv[i], "--check") == 0) {
+            checks = true;
+        } else {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    for(const RegisteredBenchmark& benchmark : getRegisteredBenchmarks()) {
+        if(benchmark.isCheck != checks) {
+            continue;
+        }
+        bool selected = filters.empty();
+        for(const char* filter : filters) {
+            if(strstr(benchmark.name, filter)) {
+                selected = true;
+            }
+        }
+        if(selected) {
+            if(checks) {
+                printf("%s\n", benchmark.name);
+            }
+            benchmark.fcn(runner);
+        }
+    }
+
+    if(jsonPath && !runner.writeJson(jsonPath)) {
+        fprintf(stderr, "Failed to write %s.\n", jsonPath);
+        return 1;
+    }
+    if(checks) {
+        printf("%u checks failed.\n", runner.getFailures());
+        return runner.getFailures() == 0 ? 0 : 1;
+    }
+    return 0;
+}
@@ -5,6 +5,8 @@
 
 #include "core/Component.h"
 
+#include <atomic>
+
 struct TransformData
 {
     vec3 translation;
@@ -39,7 +41,7 @@ struct TransformData
     mat4 toMat4() const;
 
     TransformData& operator*=(const TransformData& rhs);
-    friend TransformData& operator*(TransformData lhs, const TransformData& rhs) {
+    friend TransformData operator*(TransformData lhs, const TransformData& rhs) {
         return lhs *= rhs;
     }
 };
@@ -49,50 +51,125 @@ string to_string(const TransformData& data);
 class Transform : public Component
 {
 public:
-    Transform() : Component(get_id(Transform)) {}
+    Transform() : Component(get_id(Transform)), globalState(GLOBAL_DIRTY) {}
     virtual ~Transform();
 
+    virtual void hashState(StateHasher& hasher) const override;
+
     // Gets the relative transform.
     TransformData getRelativeTransform() const {
         return relativeTransform;
     }
     // Sets the relative transform.
     void setRelativeTransform(const TransformData& relativeTransform);
-    // Gets the global transform of this component.
-    TransformData getGlobalTransform() const;
+    /*
+    Gets the global transform of this component. The result is cached until this transform or one of its ancestors
+    changes, so repeated reads are O(1). Safe to call from systems that only read transforms.
+    */
+    const TransformData& getGlobalTransform() const;
+    // Gets the global transform as a matrix. Cached along with the global transform.
+    const mat4& getGlobalMatrix() const;
     // Sets the relative transform so that it matches globally.
     void setGlobalTransform(const TransformData& globalTransform);
     // Gets the transform of this component relative to the provided transform.
-    TransformData getTransformRelativeTo(shared_ptr<Transform> relative) const;
+    TransformData getTransformRelativeTo(const Transform* relative) const;
     // Sets the transform of this component relative to the provided transform. Only this transform will be moved.
-    void setTransformRelativeTo(const TransformData& transform, shared_ptr<Transform> relative);
+    void setTransformRelativeTo(const TransformData& transform, const Transform* relative);
 
     /*
     Replaces the current parent with the newParent (can be null to attach to world).
     If keepGlobal = true, then the global transform will not change after parent is set.
+    A parent that would create a cycle attaches to the world instead. Detaching and attaching are O(1); checking for a
+    cycle only walks up from the new parent when it is deeper than this transform.
     */
-    void setParent(shared_ptr<Transform> newParent, bool keepGlobal);
+    void setParent(Transform* newParent, bool keepGlobal);
 
     // Gets the parent of this transform.
-    shared_ptr<Transform> getParent() const;
-
-    // Gets the children of this transform.
-    vector<shared_ptr<Transform>> getChildren() const;
+    inline Transform* getParent() const { return parent.get(); }
+    inline Handle<Transform> getParentHandle() const { return parent; }
+    // The number of ancestors of this transform.
+    inline uint getDepth() const { return depth; }
+
+    // Iterates over the children of a transform by following their sibling links.
+    class ChildIterator
+    {
+    public:
+        ChildIterator(Transform* _child) : child(_child) {}
+
+        inline Transform* operator*() const { return child; }
+        inline ChildIterator& operator++() {
+            child = child->nextSibling.get();
+            return *this;
+        }
+        inline bool operator==(const ChildIterator& other) const { return child == other.child; }
+        inline bool operator!=(const ChildIterator& other) const { return child != other.child; }
+    private:
+        Transform* child;
+    };
+    struct ChildRange
+    {
+        Transform* first;
+
+        inline ChildIterator begin() const { return ChildIterator(first); }
+        inline ChildIterator end() const { return ChildIterator(nullptr); }
+    };
 
-    inline uint getUpdateId() const { return updateId; }
+    /*
+    Gets the children of this transform, in the order they were attached. Does not allocate.
+    Reparenting or destroying the current child while iterating invalidates the iteration.
+    */
+    inline ChildRange getChildren() const { return ChildRange{ firstChild.get() }; }
+    inline uint getChildCount() const { return childCount; }
 
-    uint sumUpdatesRelativeTo(shared_ptr<Transform> relative) const;
-    uint sumUpdates() const { return sumUpdatesRelativeTo(nullptr); }
+    /*
+    A version that is replaced by a new, larger one whenever this transform or one of its ancestors changes. Versions
+    are drawn from a single counter shared by all transforms, so they never repeat. 0 if the transform never changed.
+    The change tick (see Component::markChanged) is updated at the same times.
+    */
+    inline uint64_t getWorldVersion() const { return worldVersion; }
+    // The version of the last change to this transform's own relative transform or parent.
+    inline uint64_t getLocalVersion() const { return localVersion; }
+    /*
+    Has this transform moved relative to the provided transform (nullptr for the world) since its world version was
+    the provided version. O(1) when nothing above this transform changed; otherwise walks up to the relative transform.
+    */
+    bool changedRelativeToSince(const Transform* relative, uint64_t version) const;
 protected:
-    void incrementUpdateId();
+    // Gives this transform a new local version, and all of its descendants a new world version.
+    void markLocalChanged();
 private:
+    /*
+    Marks this transform and all of its descendants changed, since their global transforms moved.
+    Also refreshes the depths of the descendants, which reparenting can change.
+    */
+    void markGlobalChanged(uint64_t version);
+    // Adds this transform to the end of the parent's children. This transform must not have a parent.
+    void attach(Transform* newParent);
+    // Removes this transform from its parent's children, leaving it attached to the world.
+    void detach();
+    // Recomputes the cached global transform from the parent's, or waits for the thread already doing so.
+    void updateGlobalTransform() const;
+
+    enum : uchar { GLOBAL_CLEAN, GLOBAL_DIRTY, GLOBAL_UPDATING };
+
     TransformData relativeTransform; // The transform data relative to this transform's parent.
+    uint64_t localVersion = 0; // See getLocalVersion.
+    uint64_t worldVersion = 0; // See getWorldVersion. Never less than the parent's or localVersion.
+    Handle<Transform> parent; // The parent of this transform.
+    // The children of this transform form a doubly linked list through their sibling links.
+    Handle<Transform> firstChild;
+    Handle<Transform> lastChild;
+    Handle<Transform> prevSibling;
+    Handle<Transform> nextSibling;
+    uint childCount = 0;
+    uint depth = 0; // See getDepth.
     /*
-    Stores a number to identify this value of the transform. If the transform is changed, this value is changed.
+    The cached global transform and its matrix, valid while globalState is GLOBAL_CLEAN. A dirty transform always has
+    dirty descendants, since marking one dirty marks all of its descendants.
     */
-    uint updateId = 0;
-    weak_ptr<Transform> parent; // The parent of this transform.
-    vector<weak_ptr<Transform>> children; // The children of this transform.
+    mutable TransformData globalTransform;
+    mutable mat4 globalMatrix;
+    mutable atomic<uchar> globalState;
 };
 
 class Transformable : public Component
@@ -100,10 +177,15 @@ class Transformable : public Component
 public:
     Transformable(uint typeId) : Component(typeId) {}
 
-    weak_ptr<Transform> transform;
+    Handle<Transform> transform;
+
+    inline Transform* getTransform() const {
+        return transform.get();
+    }
 
-    inline shared_ptr<Transform> getTransform() const {
-        return transform.lock();
+    // Hashes which transform the component follows. Subclasses with their own state call this first.
+    virtual void hashState(StateHasher& hasher) const override {
+        Component::hashIdentity(hasher, transform.get());
     }
 };
 
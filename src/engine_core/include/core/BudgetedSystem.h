@@ -0,0 +1,38 @@
+#pragma once
+
+#include "std.h"
+#include "core/System.h"
+
+/*
+A system whose work does not have to finish within a frame, such as re-planning or rebuilding caches.
+Every frame it processes units of work until they run out or its budget is spent, and picks up from the same place
+next frame. Keep units small, since the budget is only checked between them.
+*/
+class BudgetedSystem : public System
+{
+public:
+    // The time the system may spend on work each frame, in milliseconds. Usually given by World::addBudgetedSystem.
+    float budgetMilliseconds = 1.0f;
+
+    /*
+    Runs work until the budget is spent. Subclasses that also do per-frame work should override frameTick and call
+    BudgetedSystem::frameTick from it.
+    */
+    virtual void frameTick(float delta) override;
+
+    // The number of units of work that are still waiting.
+    virtual size_t getBacklog() const = 0;
+    // The number of units processed during the last frame.
+    inline size_t getLastProcessed() const { return lastProcessed; }
+    // The time spent on work during the last frame, in milliseconds.
+    inline float getLastMilliseconds() const { return lastMilliseconds; }
+    // The number of frames the backlog would take to clear at the rate of recent frames. 0 when there is no backlog.
+    float getFramesBehind() const;
+protected:
+    // Processes the unit of work at the cursor and advances it. Returns false if there was no work left.
+    virtual bool processWork() = 0;
+private:
+    size_t lastProcessed = 0;
+    float lastMilliseconds = 0;
+    float averageProcessed = 0; // A moving average of the units processed per frame that had a backlog.
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "std.h"
+
+#include <mutex>
+
+#include "core/Pool.h"
+
+class World;
+class Entity;
+class Component;
+
+/*
+Records structural changes to a world (spawning and destroying entities, adding and removing components) so they can
+be applied later in one batch. Recording is thread safe, so systems on worker threads may share a buffer.
+Entities spawned through the buffer are not in the world until the buffer is applied, so components can be attached
+to them directly without the world doing any work per component.
+*/
+class CommandBuffer
+{
+public:
+    CommandBuffer() {}
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    // Constructs an entity that will be added to the world when the buffer is applied.
+    shared_ptr<Entity> spawnEntity();
+    // Adds the entity to the world when the buffer is applied.
+    void addEntity(shared_ptr<Entity> entity);
+    // Removes the entity from the world when the buffer is applied.
+    void removeEntity(shared_ptr<Entity> entity);
+    // Attaches the component to the entity when the buffer is applied.
+    void addComponent(shared_ptr<Entity> entity, shared_ptr<Component> component);
+    template<typename T>
+    shared_ptr<T> addComponent(shared_ptr<Entity> entity)
+    {
+        shared_ptr<T> t = makePooled<T>(pools);
+        addComponent(entity, t);
+        return t;
+    }
+    // Detaches the component from its owner when the buffer is applied.
+    void removeComponent(shared_ptr<Component> component);
+
+    // Moves every command recorded in other to the end of this buffer.
+    void append(CommandBuffer& other);
+
+    bool empty() const;
+
+    /*
+    Applies the recorded commands to the world in the order they were recorded, then clears the buffer.
+    Storage for added entities and components is reserved up front. Must not be called while systems are running.
+    */
+    void apply(World& world);
+private:
+    enum class CommandType : uchar
+    {
+        AddEntity, RemoveEntity, AddComponent, RemoveComponent
+    };
+
+    struct Command
+    {
+        CommandType type;
+        shared_ptr<Entity> entity;
+        shared_ptr<Component> component;
+    };
+
+    void record(Command command);
+
+    vector<Command> commands;
+    mutable mutex lock; // Guards commands.
+    shared_ptr<PoolSet> pools; // Where spawned entities and added components are allocated. Null to use the heap.
+
+    friend class World;
+};
@@ -1,27 +1,116 @@
-
 #pragma once
 
 #include "std.h"
+#include "core/Handle.h"
+#include "core/StateHash.h"
 
 class Entity;
 
 class Component : public enable_shared_from_this<Component>
 {
-protected:
-    Component(uint typeId) {
-        this->typeId = typeId;
-    }
 public:
+    typedef Component HandleBase;
+
+    Component(const Component&) = delete;
+    Component& operator=(const Component&) = delete;
+    virtual ~Component();
+
     inline uint getTypeId() const {
         return typeId;
     }
-    inline shared_ptr<Entity> getOwner() const {
-        return owner.lock();
+    // Returns a weak handle to this component.
+    inline Handle<Component> getHandle() const {
+        return handle;
+    }
+    shared_ptr<Entity> getOwner() const;
+    // Returns a handle to the entity this component is owned by. Cheaper than getOwner.
+    inline Handle<Entity> getOwnerHandle() const {
+        return owner;
+    }
+    /*
+    Adds the simulation state of this component to the hasher, for determinism checks. See World::hashState.
+    Components that hold no simulation state can leave this empty.
+    */
+    virtual void hashState(StateHasher& hasher) const {}
+    /*
+    Adds a name for the component (or null) that two runs making the same changes agree on: its type's stable id and
+    its position in its world's storage. Use it to hash references to other components, since handles differ by run.
+    */
+    static void hashIdentity(StateHasher& hasher, const Component* component);
+
+    /*
+    Records that the component was modified in the current tick of its world, so systems can skip components that
+    have not changed since they last ran. World::each and World::view call this for every component they hand out
+    as non-const. Code that mutates a component through a raw pointer or a ComponentRange calls it itself.
+    */
+    inline void markChanged() {
+        if(worldTick) {
+            changedTick = *worldTick;
+        }
+    }
+    // The world tick the component was last modified in. Adding a component to a world counts as a change.
+    inline uint getChangedTick() const {
+        return changedTick;
+    }
+    // The world tick the component was added to its world in.
+    inline uint getAddedTick() const {
+        return addedTick;
+    }
+    /*
+    Was the component modified in or after the provided tick. Pass System::getLastFrameTick or getLastGameplayTick
+    to find what changed since the system last ran. Changes made in the same tick but before the system ran are
+    reported again, so that no change is ever missed.
+    */
+    inline bool wasChangedSince(uint tick) const {
+        return changedTick >= tick;
     }
+    // Are changes to this component being recorded. Only components in a world have a tick to record.
+    inline bool tracksChanges() const {
+        return worldTick != nullptr;
+    }
+    // Was the component added to its world in or after the provided tick.
+    inline bool wasAddedSince(uint tick) const {
+        return addedTick >= tick;
+    }
+protected:
+    Component(uint typeId);
 private:
     uint typeId; // The type id that determines this component.
-    weak_ptr<Entity> owner; // The entity this component is owned by.
+    Handle<Component> handle; // The handle that refers to this component.
+    Handle<Entity> owner; // The entity this component is owned by.
+    uint storageIndex = (uint)-1; // The index of this component in its world's ComponentStorage.
+    const uint* worldTick = nullptr; // The current tick of the world this component is in, or null.
+    uint addedTick = 0; // The world tick this component was added in.
+    uint changedTick = 0; // The world tick this component was last modified in.
 
     friend class Universe;
     friend class Entity;
+    friend class ComponentStorage;
+    friend class World;
+};
+
+// Keeps components modified in or after the tick. Works as a Query or LazyQuery filter over components of any type.
+struct ChangedSince
+{
+    uint tick;
+
+    inline bool operator()(const Component& component) const { return component.wasChangedSince(tick); }
+    inline bool operator()(const Component* component) const { return component && component->wasChangedSince(tick); }
+    inline bool operator()(const shared_ptr<Component>& component) const { return operator()(component.get()); }
+};
+inline ChangedSince changedSince(uint tick) {
+    return ChangedSince{ tick };
+}
+
+// Keeps components added to their world in or after the tick. Works as a Query or LazyQuery filter.
+struct AddedSince
+{
+    uint tick;
+
+    inline bool operator()(const Component& component) const { return component.wasAddedSince(tick); }
+    inline bool operator()(const Component* component) const { return component && component->wasAddedSince(tick); }
+    inline bool operator()(const shared_ptr<Component>& component) const { return operator()(component.get()); }
 };
+inline AddedSince addedSince(uint tick) {
+    return AddedSince{ tick };
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "std.h"
+#include "core/Component.h"
+
+/*
+Stores the components of a single type in a dense array so systems can walk them linearly.
+Removal swaps the last component into the removed slot, so iteration order is not stable.
+*/
+class ComponentStorage
+{
+public:
+    // Appends the component to the end of the storage.
+    void add(Component* component);
+    // Removes the component in O(1) by swapping the last component into its slot.
+    void remove(Component* component);
+
+    inline bool contains(const Component* component) const {
+        return component->storageIndex < dense.size() && dense[component->storageIndex] == component;
+    }
+
+    // Makes room for extra more components, growing geometrically so repeated batches stay amortised O(1).
+    inline void grow(size_t extra) {
+        size_t needed = dense.size() + extra;
+        if(needed > dense.capacity()) {
+            dense.reserve(needed > dense.capacity() * 2 ? needed : dense.capacity() * 2);
+        }
+    }
+    inline size_t size() const { return dense.size(); }
+    inline bool empty() const { return dense.empty(); }
+    inline Component* const* data() const { return dense.data(); }
+private:
+    vector<Component*> dense; // The components of this type. Owned by their entities.
+};
+
+/*
+A typed range over a ComponentStorage. Iterating yields references to T with no refcounting.
+Components of this type must not be added or removed while the range is being iterated.
+*/
+template<typename T>
+class ComponentRange
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator(Component* const* _it = nullptr) : it(_it) {}
+
+        inline T& operator*() const { return *static_cast<T*>(*it); }
+        inline T* operator->() const { return static_cast<T*>(*it); }
+        inline iterator& operator++() { ++it; return *this; }
+        inline iterator operator++(int) { iterator copy = *this; ++it; return copy; }
+        inline difference_type operator-(const iterator& other) const { return it - other.it; }
+        inline bool operator==(const iterator& other) const { return it == other.it; }
+        inline bool operator!=(const iterator& other) const { return it != other.it; }
+    private:
+        Component* const* it;
+    };
+
+    ComponentRange() : first(nullptr), count(0) {}
+    ComponentRange(const ComponentStorage& storage) : first(storage.data()), count(storage.size()) {}
+    ComponentRange(Component* const* _first, size_t _count) : first(_first), count(_count) {}
+
+    inline iterator begin() const { return iterator(first); }
+    inline iterator end() const { return iterator(first + count); }
+    inline size_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+    inline T& operator[](size_t index) const { return *static_cast<T*>(first[index]); }
+private:
+    Component* const* first; // The first component in the storage.
+    size_t count; // The number of components in the range.
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "std.h"
+
+#include <bitset>
+
+// The maximum number of component types a program can use. Masks over component types have this many bits.
+#define MAX_COMPONENT_TYPES 128
+
+typedef bitset<MAX_COMPONENT_TYPES> ComponentMask;
+
+/*
+Component type ids are small and dense: the first component type used gets 0, the next 1, and so on.
+This lets per-type tables be plain arrays and sets of types be bitmasks.
+Dense ids depend on the order types are first used, so they must not be written to disk. Save files and snapshots
+should store the stable id instead, which is a hash of the type's name and is the same in every run.
+*/
+
+// Assigns the next dense id to the type with the provided signature. Use get_id rather than calling this directly.
+uint registerComponentType(const char* signature);
+
+// Returns the number of component types that have been assigned ids so far.
+uint getComponentTypeCount();
+// Returns the name of the type, as written in source (e.g. "RigidBody").
+const string& getComponentTypeName(uint typeId);
+// Returns an id for the type that is the same across runs and builds.
+uint getStableComponentTypeId(uint typeId);
+// Returns the dense id of the type with the stable id, or -1 if no such type has been used yet.
+uint findComponentTypeByStableId(uint stableId);
+
+// Returns a compiler-specific string that contains the name of T. Works on incomplete types.
+template<typename T>
+const char* getTypeSignature()
+{
+#ifdef _MSC_VER
+    return __FUNCSIG__;
+#else
+    return __PRETTY_FUNCTION__;
+#endif
+}
+
+// Extracts the type name from a signature produced by getTypeSignature.
+string extractTypeName(const string& signature);
+
+// const T shares the id of T, so views can ask for read-only access.
+template<typename T>
+inline uint getComponentTypeId()
+{
+    if constexpr(is_const<T>::value) {
+        return getComponentTypeId<typename remove_const<T>::type>();
+    } else {
+        static const uint id = registerComponentType(getTypeSignature<T>());
+        return id;
+    }
+}
+
+// Returns a mask with the bit of each of the types set.
+template<typename... Ts>
+ComponentMask makeComponentMask()
+{
+    ComponentMask mask;
+    (void)initializer_list<int>{ (mask.set(getComponentTypeId<Ts>()), 0)... };
+    return mask;
+}
+
+// Returns the number of types in the mask with an id lower than typeId.
+inline uint countTypesBelow(const ComponentMask& mask, uint typeId)
+{
+    return (uint)(mask << (MAX_COMPONENT_TYPES - typeId)).count();
+}
@@ -3,13 +3,71 @@
 
 #include "std.h"
 #include "core/Query.h"
+#include "core/Component.h"
+#include "core/Pool.h"
 
 class World;
 class Component;
 
+/*
+A range over some of an entity's components, viewed as T. Iterating does not touch refcounts.
+The range is invalidated when components are added to or removed from the entity.
+*/
+template<typename T>
+class EntityComponentRange
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator(const shared_ptr<Component>* _it = nullptr) : it(_it) {}
+
+        inline T& operator*() const { return *static_cast<T*>(it->get()); }
+        inline T* operator->() const { return static_cast<T*>(it->get()); }
+        inline iterator& operator++() { ++it; return *this; }
+        inline iterator operator++(int) { iterator copy = *this; ++it; return copy; }
+        inline difference_type operator-(const iterator& other) const { return it - other.it; }
+        inline bool operator==(const iterator& other) const { return it == other.it; }
+        inline bool operator!=(const iterator& other) const { return it != other.it; }
+    private:
+        const shared_ptr<Component>* it;
+    };
+
+    EntityComponentRange() : first(nullptr), last(nullptr) {}
+    EntityComponentRange(const shared_ptr<Component>* _first, const shared_ptr<Component>* _last)
+        : first(_first), last(_last) {}
+
+    inline iterator begin() const { return iterator(first); }
+    inline iterator end() const { return iterator(last); }
+    inline size_t size() const { return last - first; }
+    inline bool empty() const { return first == last; }
+    inline T& operator[](size_t index) const { return *static_cast<T*>(first[index].get()); }
+private:
+    const shared_ptr<Component>* first;
+    const shared_ptr<Component>* last;
+};
+
 class Entity : public enable_shared_from_this<Entity>
 {
 public:
+    typedef Entity HandleBase;
+
+    Entity();
+    Entity(const Entity&) = delete;
+    Entity& operator=(const Entity&) = delete;
+    ~Entity();
+
+    // Returns a weak handle to this entity.
+    inline Handle<Entity> getHandle() const {
+        return handle;
+    }
+
     // Returns a query that can filter down components owned by the entity.
     Query<shared_ptr<Component>> queryComponents();
 
@@ -18,10 +76,11 @@ public:
     Do not store shared_ptrs to the component afterwards.
     */
     void addComponent(shared_ptr<Component> component);
+    // Constructs the component in the pools of the entity's world (if it has been in one) and attaches it.
     template<typename T>
     shared_ptr<T> addComponent()
     {
-        shared_ptr<T> t = make_shared<T>();
+        shared_ptr<T> t = makePooled<T>(pools);
         addComponent(t);
         return t;
     }
@@ -43,36 +102,128 @@ public:
         removeComponentsByType(get_id(T));
     }
 
-    // Finds any component attached to this entity with the specified type.
+    // Finds any component attached to this entity with the specified type. O(1).
     shared_ptr<Component> findComponentByType(uint typeId);
-    // Finds all components attached to this entity with the specified type.
-    hash_set<shared_ptr<Component>> findComponentsByType(uint typeId);
+    // Finds any component attached to this entity with the specified type without touching refcounts. O(1).
+    inline Component* getComponentByType(uint typeId) const {
+        return hasComponentOfType(typeId) ? components[typeStarts[getTypeRank(typeId)]].get() : nullptr;
+    }
+    // Returns all components attached to this entity with the specified type. O(1) and does not allocate.
+    template<typename T = Component>
+    EntityComponentRange<T> findComponentsByType(uint typeId) const {
+        if(!hasComponentOfType(typeId)) {
+            return EntityComponentRange<T>();
+        }
+        uint rank = getTypeRank(typeId);
+        const shared_ptr<Component>* data = components.data();
+        return EntityComponentRange<T>(data + typeStarts[rank], data + typeStarts[rank + 1]);
+    }
 
     template<typename T>
     shared_ptr<T> findComponent() {
         return static_pointer_cast<T>(findComponentByType(get_id(T)));
     }
 
+    // Does this entity have a component of the type. A single bit test.
+    inline bool hasComponentOfType(uint typeId) const {
+        return componentMask.test(typeId);
+    }
     template<typename T>
-    hash_set<shared_ptr<T>> findComponents() {
-        hash_set<shared_ptr<Component>> components = findComponentsByType(get_id(T));
-        hash_set<shared_ptr<T>> results;
-        for(shared_ptr<Component>& c : components) {
-            results.insert(static_pointer_cast<T>(c));
-        }
-        return results;
+    bool hasComponent() const {
+        return hasComponentOfType(get_id(T));
+    }
+    // Does this entity have a component of every type in the mask.
+    inline bool hasComponents(const ComponentMask& mask) const {
+        return (componentMask & mask) == mask;
+    }
+    template<typename... Ts>
+    bool hasComponents() const {
+        return hasComponents(makeComponentMask<Ts...>());
+    }
+    // The set of component types attached to this entity.
+    inline const ComponentMask& getComponentMask() const {
+        return componentMask;
+    }
+    // Returns the number of components of the type attached to this entity.
+    size_t countComponentsOfType(uint typeId) const;
+
+    template<typename T>
+    T* getComponent() const {
+        return static_cast<T*>(getComponentByType(get_id(T)));
+    }
+
+    template<typename T>
+    EntityComponentRange<T> findComponents() const {
+        return findComponentsByType<T>(get_id(T));
     }
 
     inline shared_ptr<World> getWorld() const {
         return world.lock();
     }
-    inline hash_set<shared_ptr<Component>> getComponents() const {
+    // The components attached to this entity, sorted by type id.
+    inline const vector<shared_ptr<Component>>& getComponents() const {
         return components;
     }
 private:
+    Handle<Entity> handle; // The handle that refers to this entity.
     weak_ptr<World> world; // The world this entity is in.
-    hash_set<shared_ptr<Component>> components; // The components attached to this entity.
+    /*
+    The components attached to this entity, sorted by type id so the components of each type are contiguous.
+    The components of the type with rank r (the r-th lowest type id in componentMask) are at
+    [typeStarts[r], typeStarts[r + 1]). The last entry of typeStarts is always components.size().
+    */
+    vector<shared_ptr<Component>> components;
+    vector<ushort> typeStarts;
+    ComponentMask componentMask; // The types of the components attached to this entity.
+    shared_ptr<PoolSet> pools; // Where this entity's components are allocated. Null to use the heap.
+
+    // Returns the position of the type among the types attached to this entity.
+    inline uint getTypeRank(uint typeId) const {
+        return countTypesBelow(componentMask, typeId);
+    }
+    // Inserts the component into the table after any others of its type.
+    void insertComponent(shared_ptr<Component> component);
+    // Removes the component at the index from the table.
+    void eraseComponent(size_t index);
+    // Returns the index of the component in the table, or -1 if it is not attached.
+    size_t findComponentIndex(const Component* component) const;
 
     friend class Universe;
     friend class World;
+    friend class View;
+    friend class CommandBuffer;
 };
+
+template<typename T>
+bool filterByType(shared_ptr<Component> component) {
+    return component->getTypeId() == get_id(T);
+}
+
+// Keeps entities that have a component of type T.
+template<typename T>
+bool filterByComponent(shared_ptr<Entity> entity) {
+    return entity->hasComponent<T>();
+}
+
+shared_ptr<Entity> mapToOwner(shared_ptr<Component> component);
+
+template<typename T>
+shared_ptr<T> mapToComponent(shared_ptr<Entity> entity)
+{
+    return entity ? entity->findComponent<T>() : nullptr;
+}
+
+template<typename T>
+shared_ptr<T> mapToSibling(shared_ptr<Component> component)
+{
+    Entity* owner = component->getOwnerHandle().get();
+    return owner ? owner->findComponent<T>() : nullptr;
+}
+
+// Finds a component of type T on the same entity as the component without touching refcounts.
+template<typename T>
+T* getSibling(const Component& component)
+{
+    Entity* owner = component.getOwnerHandle().get();
+    return owner ? owner->getComponent<T>() : nullptr;
+}
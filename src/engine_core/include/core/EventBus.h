@@ -0,0 +1,102 @@
+#pragma once
+
+#include "std.h"
+#include "core/Pool.h"
+
+#include <mutex>
+#include <atomic>
+
+// The maximum number of event types. Each type published on any bus uses one.
+#define MAX_EVENT_TYPES 256
+
+// Returns a new event type index. Use getEventTypeIndex rather than calling this directly.
+uint registerEventType();
+
+template<typename E>
+inline uint getEventTypeIndex()
+{
+    static uint index = registerEventType();
+    return index;
+}
+
+class EventChannelBase
+{
+public:
+    virtual ~EventChannelBase() {}
+    virtual void swap() = 0;
+};
+
+/*
+The events of a single type, double buffered.
+Publishing appends to the pending buffer. A swap makes the pending events readable and drops the previously readable
+ones. Both buffers keep their capacity across swaps, so a steady stream of events does not allocate.
+*/
+template<typename E>
+class EventChannel : public EventChannelBase
+{
+public:
+    // Appends the event to the pending buffer. Safe to call from several threads at once.
+    inline void publish(const E& event) {
+        lock_guard<SpinLock> guard(lock);
+        pending.push_back(event);
+    }
+    // Appends a batch of events under a single lock.
+    template<typename It>
+    void publish(It first, It last) {
+        lock_guard<SpinLock> guard(lock);
+        pending.insert(pending.end(), first, last);
+    }
+    // The events published before the last swap, in one contiguous batch. Safe to read while others publish.
+    inline const vector<E>& read() const {
+        return current;
+    }
+
+    virtual void swap() override {
+        current.clear();
+        std::swap(current, pending);
+    }
+private:
+    vector<E> current; // The readable events.
+    vector<E> pending; // The events published since the last swap.
+    SpinLock lock; // Guards pending.
+};
+
+/*
+Typed events shared between systems. Each event type has its own channel, created the first time it is used.
+Events published during one tick are read during the next, so every reader sees the same batch regardless of the
+order systems run in.
+*/
+class EventBus
+{
+public:
+    EventBus();
+    ~EventBus();
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    template<typename E>
+    EventChannel<E>& getChannel()
+    {
+        uint index = getEventTypeIndex<E>();
+        EventChannelBase* channel = channels[index].load(memory_order_acquire);
+        return *static_cast<EventChannel<E>*>(channel ? channel : addChannel(index, new EventChannel<E>()));
+    }
+    template<typename E>
+    inline void publish(const E& event) {
+        getChannel<E>().publish(event);
+    }
+    template<typename E>
+    inline const vector<E>& read() {
+        return getChannel<E>().read();
+    }
+
+    // Swaps every channel. Must not be called while anything publishes or reads.
+    void swap();
+private:
+    // Stores the channel under the index, unless another thread got there first. Returns the stored channel.
+    EventChannelBase* addChannel(uint index, EventChannelBase* channel);
+
+    atomic<EventChannelBase*> channels[MAX_EVENT_TYPES]; // Indexed by event type index. Lookups do not lock.
+    mutex lock; // Guards adding channels.
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "std.h"
+
+#include <atomic>
+
+/*
+A process-wide table mapping handle indices to objects.
+Each slot carries a generation that is bumped whenever the slot is released, so handles to
+destroyed objects stop resolving. Slots are allocated in fixed pages that never move, so
+resolving a handle never races with the table growing.
+Lock-free: any thread may acquire, release and resolve at once. Free slots form a stack whose
+head carries a tag, so a slot popped and pushed back between a thread's read and its swap is
+never mistaken for an unchanged head.
+*/
+class HandleTable
+{
+public:
+    HandleTable();
+    ~HandleTable();
+
+    // Assigns a slot to the object. Writes the slot's index and generation to the out parameters.
+    // Throws if MAX_PAGES * PAGE_SIZE slots are already in use.
+    void acquire(void* object, uint& index, uint& generation);
+    // Frees the slot so it can be reused. Any handles to the slot become invalid.
+    void release(uint index);
+
+    /*
+    Returns the object in the slot, or nullptr if the generation does not match.
+    The generation is read again after the object, since the slot may have been released and
+    reused in between. Reading a reused slot's object also makes its release visible.
+    */
+    inline void* resolve(uint index, uint generation) const
+    {
+        Slot* page = pages[index >> PAGE_BITS].load(memory_order_acquire);
+        if(!page) {
+            return nullptr;
+        }
+        const Slot& slot = page[index & PAGE_MASK];
+        if(slot.generation.load(memory_order_acquire) != generation) {
+            return nullptr;
+        }
+        void* object = slot.object.load(memory_order_acquire);
+        return slot.generation.load(memory_order_relaxed) == generation ? object : nullptr;
+    }
+private:
+    static const uint PAGE_BITS = 12;
+    static const uint PAGE_SIZE = 1 << PAGE_BITS;
+    static const uint PAGE_MASK = PAGE_SIZE - 1;
+    static const uint MAX_PAGES = 4096;
+
+    static const uint NO_SLOT = (uint)-1;
+
+    struct Slot
+    {
+        atomic<void*> object;
+        atomic<uint> generation; // Generation 0 is never handed out, so default handles never resolve.
+        atomic<uint> nextFree; // The next free slot if this slot is free.
+    };
+
+    inline Slot& getSlot(uint index) const {
+        return pages[index >> PAGE_BITS].load(memory_order_acquire)[index & PAGE_MASK];
+    }
+
+    atomic<Slot*> pages[MAX_PAGES]; // The pages of slots. Pages are never freed until the table is.
+    atomic<uint> slotCount; // The number of slots that have been handed out at least once.
+    // The first free slot (or NO_SLOT) in the low 32 bits, and a count of changes to the head in the high 32 bits.
+    atomic<uint64_t> freeHead;
+};
+
+template<typename Base>
+HandleTable& getHandleTable()
+{
+    static HandleTable table;
+    return table;
+}
+
+/*
+A weak, generational reference to an Entity or Component (or a subclass).
+Checking validity and resolving is O(1) and does not touch any refcounts.
+T must define HandleBase as the root type that owns the handle (Entity or Component).
+*/
+template<typename T>
+class Handle
+{
+public:
+    Handle() : index(0), generation(0) {}
+    Handle(nullptr_t) : Handle() {}
+    Handle(const T* object) : Handle() {
+        if(object) {
+            *this = unchecked(object->getHandle());
+        }
+    }
+    template<typename U>
+    Handle(const shared_ptr<U>& object) : Handle(static_cast<const T*>(object.get())) {}
+    // Converts a handle to a derived type into a handle to its base type.
+    template<typename U, typename = typename enable_if<is_convertible<U*, T*>::value>::type>
+    Handle(const Handle<U>& other) : index(other.index), generation(other.generation) {}
+
+    // Reinterprets a handle as a handle to another type. The caller must ensure the object is a U.
+    template<typename U>
+    static Handle<T> unchecked(const Handle<U>& other) {
+        Handle<T> result;
+        result.index = other.index;
+        result.generation = other.generation;
+        return result;
+    }
+
+    // Returns the object this handle refers to, or nullptr if it has been destroyed.
+    inline T* get() const {
+        typedef typename T::HandleBase Base;
+        return static_cast<T*>(static_cast<Base*>(getHandleTable<Base>().resolve(index, generation)));
+    }
+    inline T* operator->() const { return get(); }
+    inline T& operator*() const { return *get(); }
+
+    // Returns true iff the object this handle refers to is still alive.
+    inline bool valid() const { return get() != nullptr; }
+    inline explicit operator bool() const { return valid(); }
+
+    inline uint getIndex() const { return index; }
+    inline uint getGeneration() const { return generation; }
+    inline uint64_t toUint64() const { return ((uint64_t)generation << 32) | index; }
+
+    inline bool operator==(const Handle<T>& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    inline bool operator!=(const Handle<T>& other) const { return !(*this == other); }
+    inline bool operator<(const Handle<T>& other) const { return toUint64() < other.toUint64(); }
+private:
+    uint index;
+    uint generation;
+
+    template<typename U>
+    friend class Handle;
+    friend class Component;
+    friend class Entity;
+};
+
+namespace std
+{
+    template<typename T>
+    struct hash<Handle<T>>
+    {
+        size_t operator()(const Handle<T>& handle) const {
+            return hash<uint64_t>()(handle.toUint64());
+        }
+    };
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "std.h"
+
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+/*
+Counts the jobs that are still outstanding in a group. Pass one to JobSystem::submit and wait on it with JobSystem::wait.
+*/
+class JobCounter
+{
+public:
+    JobCounter() : pending(0) {}
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    inline bool isDone() const { return pending.load(memory_order_acquire) == 0; }
+private:
+    atomic<uint> pending; // The number of jobs submitted with this counter that have not finished.
+
+    friend class JobSystem;
+};
+
+/*
+A work-stealing pool of worker threads.
+Every worker owns a deque: it pushes and pops its own jobs at the back, and steals from the front of the others
+when it runs out. Jobs submitted from threads outside the pool go to a shared queue.
+Threads that wait on jobs help run them, so waiting inside a job does not deadlock, and a pool with no workers
+still makes progress on the waiting thread.
+*/
+class JobSystem
+{
+public:
+    // Starts the provided number of worker threads. With zero workers, jobs only run on waiting threads.
+    JobSystem(uint workerCount = getDefaultWorkerCount());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Queues the job to run on any thread of the pool. If counter is provided, it tracks the job until it finishes.
+    void submit(function<void()> job, JobCounter* counter = nullptr);
+    // Runs one queued job on the calling thread. Returns false if there were no queued jobs.
+    bool tryRunJob();
+    // Runs queued jobs on the calling thread until every job tracked by the counter has finished.
+    void wait(const JobCounter& counter);
+
+    /*
+    Calls fcn(first, last) over consecutive ranges covering [0, count), spread across the pool.
+    Ranges hold at least grainSize indices. A grainSize of 0 picks a size that gives each thread a few ranges.
+    Returns once every range is done. The calling thread runs ranges too.
+    */
+    template<typename F>
+    void parallelFor(size_t count, size_t grainSize, const F& fcn);
+
+    inline uint getWorkerCount() const { return (uint)workers.size(); }
+
+    // One worker for every hardware thread other than the calling thread.
+    static uint getDefaultWorkerCount();
+private:
+    struct Job
+    {
+        function<void()> fcn;
+        JobCounter* counter;
+    };
+
+    // The jobs of one worker. Padded so that workers do not share cache lines.
+    struct alignas(64) WorkQueue
+    {
+        deque<Job> jobs;
+        mutex lock;
+    };
+
+    void workerLoop(uint index);
+    // Takes a job for the calling thread: its own queue first, then the shared queue, then stealing.
+    bool takeJob(Job& job);
+    void runJob(Job& job);
+
+    vector<thread> workers;
+    unique_ptr<WorkQueue[]> queues; // One queue per worker.
+    WorkQueue sharedQueue; // Jobs submitted from threads outside the pool.
+
+    atomic<size_t> queuedJobs; // The number of jobs in all queues.
+    atomic<uint> sleepingWorkers; // The number of workers waiting for jobs.
+    atomic<bool> stopping; // Set when the workers should exit.
+    mutex sleepLock; // Guards workers going to sleep.
+    condition_variable jobAvailable;
+};
+
+template<typename F>
+void JobSystem::parallelFor(size_t count, size_t grainSize, const F& fcn)
+{
+    if(count == 0) {
+        return;
+    }
+    if(grainSize == 0) {
+        size_t ranges = (size_t)(getWorkerCount() + 1) * 4;
+        grainSize = (count + ranges - 1) / ranges;
+    }
+    if(grainSize >= count) {
+        fcn((size_t)0, count);
+        return;
+    }
+
+    JobCounter counter;
+    // Keep the first range for the calling thread.
+    for(size_t first = grainSize; first < count; first += grainSize) {
+        size_t last = first + grainSize < count ? first + grainSize : count;
+        submit([&fcn, first, last]() { fcn(first, last); }, &counter);
+    }
+    fcn((size_t)0, grainSize);
+    wait(counter);
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "std.h"
+
+#include <iterator>
+#include <type_traits>
+
+/*
+Lazy query pipelines.
+
+Unlike Query, a LazyQuery never copies its source or materialises intermediate results.
+Each stage (filter, map, cast, ...) wraps the previous stage's range in a typed adapter,
+so the whole chain is inlined into a single pass over the source when it is iterated.
+A pipeline only borrows its source: the source storage must outlive the query and must not be
+structurally modified while the query is being iterated.
+*/
+
+// Yields the elements of Range that satisfy Predicate.
+template<typename Range, typename Predicate>
+class FilterRange
+{
+public:
+    typedef decltype(declval<const Range&>().begin()) base_iterator;
+
+    class iterator
+    {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using reference = decltype(*declval<base_iterator&>());
+        using value_type = typename remove_reference<reference>::type;
+        using difference_type = ptrdiff_t;
+        using pointer = value_type*;
+
+        iterator(base_iterator _it, base_iterator _end, const Predicate* _predicate)
+            : it(_it), end(_end), predicate(_predicate) { skip(); }
+
+        inline reference operator*() const { return *it; }
+        inline iterator& operator++() { ++it; skip(); return *this; }
+        inline bool operator==(const iterator& other) const { return it == other.it; }
+        inline bool operator!=(const iterator& other) const { return it != other.it; }
+    private:
+        // Advances until the predicate passes or the end is reached.
+        inline void skip() {
+            while(it != end && !(*predicate)(*it)) {
+                ++it;
+            }
+        }
+
+        base_iterator it;
+        base_iterator end;
+        const Predicate* predicate;
+    };
+
+    FilterRange(Range _range, Predicate _predicate) : range(move(_range)), predicate(move(_predicate)) {}
+
+    inline iterator begin() const { return iterator(range.begin(), range.end(), &predicate); }
+    inline iterator end() const { return iterator(range.end(), range.end(), &predicate); }
+private:
+    Range range;
+    Predicate predicate;
+};
+
+// Yields Function applied to each element of Range.
+template<typename Range, typename Function>
+class MapRange
+{
+public:
+    typedef decltype(declval<const Range&>().begin()) base_iterator;
+
+    class iterator
+    {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using reference = decltype(declval<const Function&>()(*declval<base_iterator&>()));
+        using value_type = typename remove_cv<typename remove_reference<reference>::type>::type;
+        using difference_type = ptrdiff_t;
+        using pointer = value_type*;
+
+        iterator(base_iterator _it, const Function* _function) : it(_it), function(_function) {}
+
+        inline reference operator*() const { return (*function)(*it); }
+        inline iterator& operator++() { ++it; return *this; }
+        inline bool operator==(const iterator& other) const { return it == other.it; }
+        inline bool operator!=(const iterator& other) const { return it != other.it; }
+    private:
+        base_iterator it;
+        const Function* function;
+    };
+
+    MapRange(Range _range, Function _function) : range(move(_range)), function(move(_function)) {}
+
+    inline iterator begin() const { return iterator(range.begin(), &function); }
+    inline iterator end() const { return iterator(range.end(), &function); }
+private:
+    Range range;
+    Function function;
+};
+
+/*
+Yields every element of every group produced by applying Function to each element of Range.
+The groups are iterated in place, so Function should return a reference or a cheap range.
+*/
+template<typename Range, typename Function>
+class FlatMapRange
+{
+public:
+    typedef decltype(declval<const Range&>().begin()) base_iterator;
+    typedef decltype(declval<const Function&>()(*declval<base_iterator&>())) group_type;
+    typedef typename remove_reference<group_type>::type group_value;
+    typedef decltype(declval<group_value&>().begin()) group_iterator;
+
+    static_assert(is_lvalue_reference<group_type>::value,
+        "map_group functions must return a reference to a group that outlives the iteration.");
+
+    class iterator
+    {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using reference = decltype(*declval<group_iterator&>());
+        using value_type = typename remove_cv<typename remove_reference<reference>::type>::type;
+        using difference_type = ptrdiff_t;
+        using pointer = value_type*;
+
+        iterator(base_iterator _it, base_iterator _end, const Function* _function)
+            : it(_it), end(_end), function(_function) { if(it != end) { enter(); } }
+
+        inline reference operator*() const { return *inner; }
+        inline iterator& operator++() {
+            ++inner;
+            if(inner == innerEnd) {
+                ++it;
+                if(it != end) {
+                    enter();
+                }
+            }
+            return *this;
+        }
+        inline bool operator==(const iterator& other) const { return it == other.it && (it == end || inner == other.inner); }
+        inline bool operator!=(const iterator& other) const { return !(*this == other); }
+    private:
+        // Moves to the first element of the next non-empty group, starting at the current group.
+        inline void enter() {
+            while(true) {
+                group_type group = (*function)(*it);
+                inner = group.begin();
+                innerEnd = group.end();
+                if(inner != innerEnd || ++it == end) {
+                    return;
+                }
+            }
+        }
+
+        base_iterator it;
+        base_iterator end;
+        group_iterator inner;
+        group_iterator innerEnd;
+        const Function* function;
+    };
+
+    FlatMapRange(Range _range, Function _function) : range(move(_range)), function(move(_function)) {}
+
+    inline iterator begin() const { return iterator(range.begin(), range.end(), &function); }
+    inline iterator end() const { return iterator(range.end(), range.end(), &function); }
+private:
+    Range range;
+    Function function;
+};
+
+template<typename Range>
+class LazyQuery
+{
+public:
+    typedef decltype(declval<const Range&>().begin()) iterator;
+    typedef decltype(*declval<iterator&>()) reference;
+
+    LazyQuery(Range _range) : range(move(_range)) {}
+
+    // Keeps only the elements satisfying the predicate.
+    template<typename Predicate>
+    LazyQuery<FilterRange<Range, Predicate>> filter(Predicate predicate) const {
+        return FilterRange<Range, Predicate>(range, move(predicate));
+    }
+
+    // Transforms each element with the function.
+    template<typename Function>
+    LazyQuery<MapRange<Range, Function>> map(Function function) const {
+        return MapRange<Range, Function>(range, move(function));
+    }
+
+    // Transforms each element with a function returning a pointer, dropping null results.
+    template<typename Function>
+    auto map_ptr(Function function) const {
+        return map(move(function)).filter([](const auto& ptr) { return ptr != nullptr; });
+    }
+
+    // Replaces each element with every element of the group the function returns for it.
+    template<typename Function>
+    LazyQuery<FlatMapRange<Range, Function>> map_group(Function function) const {
+        return FlatMapRange<Range, Function>(range, move(function));
+    }
+
+    // Static casts each element (references or pointers) to U.
+    template<typename U>
+    auto cast() const {
+        return map([](reference element) -> U { return static_cast<U>(element); });
+    }
+
+    // Calls the function on every element. This is usually the tightest loop the compiler can produce.
+    template<typename Function>
+    void forEach(Function function) const {
+        for(auto it = range.begin(), end = range.end(); it != end; ++it) {
+            function(*it);
+        }
+    }
+
+    // Counts the elements. This runs the whole pipeline.
+    size_t count() const {
+        size_t n = 0;
+        for(auto it = range.begin(), end = range.end(); it != end; ++it) {
+            n++;
+        }
+        return n;
+    }
+
+    // Returns true iff the pipeline produces any element.
+    bool any() const {
+        return range.begin() != range.end();
+    }
+
+    // Inserts every element into the container (anything with insert(end, value)).
+    template<typename Container>
+    Container& collect(Container& container) const {
+        for(auto it = range.begin(), end = range.end(); it != end; ++it) {
+            container.insert(container.end(), *it);
+        }
+        return container;
+    }
+
+    inline iterator begin() const { return range.begin(); }
+    inline iterator end() const { return range.end(); }
+private:
+    Range range;
+};
+
+// Starts a lazy pipeline over a range, e.g. lazyQuery(world->getComponentsOfType<T>()).
+template<typename Range>
+LazyQuery<Range> lazyQuery(Range range)
+{
+    return LazyQuery<Range>(move(range));
+}
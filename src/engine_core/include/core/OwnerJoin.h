@@ -0,0 +1,70 @@
+#pragma once
+
+#include "std.h"
+#include "core/ComponentStorage.h"
+#include "core/Entity.h"
+
+/*
+Joins every component of type A with a component of type B that shares its owner.
+Iterating yields pair<A*, B*>, skipping any A whose owner has no B. The B is the owner's first component of that
+type, as with Entity::getComponentByType.
+
+Each A looks up its sibling on its owner, which is O(1), so nothing is hashed or allocated.
+As with ComponentRange, neither type may be added or removed while the join is being iterated.
+*/
+template<typename A, typename B>
+class OwnerJoinRange
+{
+public:
+    typedef pair<A*, B*> value_type;
+
+    class iterator
+    {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = OwnerJoinRange::value_type;
+        using reference = value_type;
+        using difference_type = ptrdiff_t;
+        using pointer = value_type*;
+
+        iterator(const OwnerJoinRange* _range, Component* const* _it)
+            : range(_range), it(_it), current(nullptr, nullptr) { skip(); }
+
+        inline value_type operator*() const { return current; }
+        inline iterator& operator++() { ++it; skip(); return *this; }
+        inline bool operator==(const iterator& other) const { return it == other.it; }
+        inline bool operator!=(const iterator& other) const { return it != other.it; }
+    private:
+        // Advances until a component with a matching sibling is found or the end is reached.
+        inline void skip() {
+            for(; it != range->leftEnd; ++it) {
+                if(Component* partner = range->findPartner(**it)) {
+                    current = value_type(static_cast<A*>(*it), static_cast<B*>(partner));
+                    return;
+                }
+            }
+        }
+
+        const OwnerJoinRange* range;
+        Component* const* it;
+        value_type current; // The pair at the current position.
+    };
+
+    OwnerJoinRange() : leftBegin(nullptr), leftEnd(nullptr), rightType(0) {}
+    OwnerJoinRange(const ComponentStorage& left, uint _rightType)
+        : leftBegin(left.data()), leftEnd(left.data() + left.size()), rightType(_rightType)
+    { }
+
+    inline iterator begin() const { return iterator(this, leftBegin); }
+    inline iterator end() const { return iterator(this, leftEnd); }
+private:
+    // Finds the component of the right type that shares an owner with the provided component.
+    inline Component* findPartner(const Component& component) const {
+        const Entity* owner = component.getOwnerHandle().get();
+        return owner ? owner->getComponentByType(rightType) : nullptr;
+    }
+
+    Component* const* leftBegin;
+    Component* const* leftEnd;
+    uint rightType; // The type id of B.
+};
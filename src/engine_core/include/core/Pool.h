@@ -0,0 +1,197 @@
+#pragma once
+
+#include "std.h"
+
+#include <mutex>
+#include <atomic>
+
+#define POOL_SLAB_ALIGNMENT 64
+// The maximum number of types that can be pooled. Each allocated type (not each component type) uses one.
+#define MAX_POOL_TYPES 256
+
+// Usage statistics of a single pool.
+struct PoolStats
+{
+    string name; // The name of the type the pool was created for.
+    size_t blockSize = 0; // The size of each allocation in bytes.
+    size_t liveCount = 0; // The number of blocks in use.
+    size_t slabCount = 0; // The number of slabs allocated.
+    size_t capacity = 0; // The number of blocks across all slabs.
+
+    // The fraction of allocated blocks that are not in use.
+    inline float getFragmentation() const {
+        return capacity == 0 ? 0.0f : 1.0f - (float)liveCount / capacity;
+    }
+};
+
+// A minimal lock for very short critical sections. Cheaper than a mutex when uncontended.
+class SpinLock
+{
+public:
+    inline void lock() {
+        while(flag.test_and_set(memory_order_acquire)) {
+            this_thread::yield();
+        }
+    }
+    inline void unlock() {
+        flag.clear(memory_order_release);
+    }
+private:
+    atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+
+/*
+A pool of fixed size blocks, carved out of cache line aligned slabs.
+Freed blocks go on a free list for reuse. Slabs are only returned to the system when the pool is destroyed,
+all at once, so tearing down many objects never calls free per object.
+*/
+class Pool
+{
+public:
+    Pool(const string& name, size_t blockSize, size_t blockAlignment);
+    ~Pool();
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    void* allocate();
+    void deallocate(void* block);
+
+    PoolStats getStats() const;
+
+    inline size_t getBlockSize() const { return blockSize; }
+private:
+    // The number of bytes in each slab. Small enough to stay cheap for rare types.
+    static const size_t SLAB_BYTES = 16 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    void addSlab();
+
+    string name;
+    size_t blockSize;
+    size_t blocksPerSlab;
+    size_t slabAlignment;
+    vector<void*> slabs;
+    FreeBlock* freeList = nullptr; // The blocks that can be handed out.
+    size_t liveCount = 0; // The number of blocks handed out and not yet returned.
+    mutable SpinLock lock; // Guards everything above.
+};
+
+// Returns a small index unique to T, used to find T's pool in a PoolSet.
+uint registerPoolType();
+template<typename T>
+inline uint getPoolTypeIndex()
+{
+    static const uint index = registerPoolType();
+    return index;
+}
+
+/*
+One pool per type. A world owns a pool set for its entities and components.
+Every block allocated from the set keeps the set alive, so objects may safely outlive the world that created them;
+the slabs are freed once the world and every object allocated from it are gone.
+*/
+class PoolSet
+{
+public:
+    // Creates a pool set. The returned pointer counts as a single reference, however many copies of it exist.
+    static shared_ptr<PoolSet> create();
+
+    PoolSet(const PoolSet&) = delete;
+    PoolSet& operator=(const PoolSet&) = delete;
+
+    // Called for every block allocated from and returned to the set. The set deletes itself when unreferenced.
+    inline void retain() {
+        references.fetch_add(1, memory_order_relaxed);
+    }
+    inline void release() {
+        if(references.fetch_sub(1, memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    // Returns the pool for the type with the index, creating it with the provided layout if needed.
+    inline Pool& getPool(uint typeIndex, const char* signature, size_t blockSize, size_t blockAlignment)
+    {
+        Pool* pool = pools[typeIndex].load(memory_order_acquire);
+        return pool ? *pool : createPool(typeIndex, signature, blockSize, blockAlignment);
+    }
+
+    vector<PoolStats> getStats() const;
+private:
+    PoolSet();
+    ~PoolSet();
+
+    Pool& createPool(uint typeIndex, const char* signature, size_t blockSize, size_t blockAlignment);
+
+    atomic<Pool*> pools[MAX_POOL_TYPES]; // Indexed by pool type index. Lookups do not lock.
+    mutex lock; // Guards creating pools.
+    atomic<size_t> references; // Live blocks, plus one for the owners of the pointer returned by create.
+};
+
+/*
+An allocator that draws from a PoolSet. Use with allocate_shared, which rebinds the allocator to a type holding both
+the shared_ptr control block and the object, so each object takes a single block.
+*/
+template<typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    PoolAllocator(const shared_ptr<PoolSet>& _pools)
+        : pools(_pools.get()), signature(getTypeSignature<T>())
+    { }
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other)
+        : pools(other.pools), signature(other.signature)
+    { }
+
+    T* allocate(size_t count)
+    {
+        if(count != 1) {
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+        T* block = static_cast<T*>(getPool().allocate());
+        pools->retain();
+        return block;
+    }
+
+    void deallocate(T* object, size_t count)
+    {
+        if(count != 1) {
+            ::operator delete(object);
+            return;
+        }
+        getPool().deallocate(object);
+        pools->release();
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const { return pools == other.pools; }
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const { return pools != other.pools; }
+private:
+    // The pool is keyed by the type actually allocated, so every block in a pool has the same layout.
+    inline Pool& getPool() const {
+        return pools->getPool(getPoolTypeIndex<T>(), signature, sizeof(T), alignof(T));
+    }
+
+    // Blocks keep the set alive rather than the allocator, so copying the allocator is free.
+    PoolSet* pools;
+    const char* signature; // Names the type this allocator was first created for, for stats.
+
+    template<typename U>
+    friend class PoolAllocator;
+};
+
+// Constructs a T in the pool set if there is one, or on the heap otherwise.
+template<typename T>
+shared_ptr<T> makePooled(const shared_ptr<PoolSet>& pools)
+{
+    return pools ? allocate_shared<T>(PoolAllocator<T>(pools)) : make_shared<T>();
+}
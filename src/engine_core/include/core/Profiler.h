@@ -0,0 +1,139 @@
+#pragma once
+
+#include "std.h"
+
+/*
+Scoped timing instrumentation. Build with ENGINE_PROFILING to enable it. Without it, the macros below expand to
+nothing and the profiler is not compiled at all.
+
+PROFILE_SCOPE(name) times the rest of the enclosing scope. name must outlive the profiler: use a string literal or
+a name from Profiler::intern.
+PROFILE_COLLECT() moves the samples recorded by every thread into the profiler. Universe::tick calls it once a frame.
+*/
+#ifdef ENGINE_PROFILING
+
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstring>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COLLECT() Profiler::get().collect()
+
+// One timed scope.
+struct ProfileEvent
+{
+    const char* name;
+    uint64_t start; // Nanoseconds since the profiler started.
+    uint64_t end;
+    uint thread; // The index of the thread that recorded the event.
+};
+
+// Durations of the recent samples of one scope, in milliseconds.
+struct ProfileSummary
+{
+    const char* name;
+    size_t samples; // The number of samples the durations are computed from.
+    double min;
+    double average;
+    double p99;
+};
+
+class Profiler
+{
+public:
+    static Profiler& get();
+
+    // Returns a copy of the name that lives as long as the profiler, for names that are built at runtime.
+    const char* intern(const string& name);
+    // Returns the readable name of the type, interned. Used to label the samples of systems.
+    const char* internTypeName(const type_info& type);
+    /*
+    Records a finished scope on the calling thread. Lock-free unless this is the thread's first sample, which takes a
+    ring buffer left behind by an exited thread or allocates a new one.
+    */
+    void record(const char* name, uint64_t start, uint64_t end);
+    // Nanoseconds since the profiler started.
+    static uint64_t now();
+
+    /*
+    Moves the samples of every thread into the trace and the rolling summaries.
+    Threads that record more than a ring buffer's worth of samples between collections lose their oldest samples.
+    */
+    void collect();
+    // Writes the collected trace in the Chrome trace event format (for chrome://tracing or Perfetto).
+    bool writeChromeTrace(const string& path);
+    // Returns the min, average and p99 duration of the recent samples of every scope, sorted by name.
+    vector<ProfileSummary> getSummary();
+    // Forgets every collected sample.
+    void clear();
+
+    // The number of samples a thread can record between collections.
+    static const size_t THREAD_BUFFER_SIZE = 1 << 14;
+    // The number of events the trace keeps. Older events are dropped.
+    static const size_t MAX_TRACE_EVENTS = 1 << 20;
+    // The number of recent samples each summary is computed from.
+    static const size_t SUMMARY_WINDOW = 256;
+private:
+    // A single producer ring buffer of the events recorded by one thread.
+    struct ThreadBuffer
+    {
+        ProfileEvent events[THREAD_BUFFER_SIZE];
+        atomic<uint64_t> head; // The number of events ever written. Only the owning thread writes it.
+        uint64_t tail = 0; // The number of events ever collected. Only touched while collecting.
+        uint thread = 0;
+
+        ThreadBuffer() : head(0) {}
+    };
+
+    // The recent durations of one scope.
+    struct RollingSamples
+    {
+        vector<double> durations; // A ring of at most SUMMARY_WINDOW durations.
+        size_t next = 0; // Where the next duration goes once the ring is full.
+    };
+
+    Profiler() {}
+    ThreadBuffer* getThreadBuffer();
+    // Called when the thread that owns the buffer exits. The buffer's samples are still collected.
+    void releaseThreadBuffer(ThreadBuffer* buffer);
+
+    mutex lock; // Guards everything below.
+    vector<unique_ptr<ThreadBuffer>> buffers;
+    vector<ThreadBuffer*> freeBuffers; // Buffers whose threads exited, ready for new threads.
+    hash_set<string> names; // Interned names.
+    hash_map<type_index, const char*> typeNames; // Interned type names.
+    vector<ProfileEvent> trace; // A ring of at most MAX_TRACE_EVENTS events.
+    size_t traceNext = 0; // Where the next event goes once the trace is full.
+    // Compares names by their text, so the same name from different string literals shares a summary.
+    struct NameLess
+    {
+        inline bool operator()(const char* a, const char* b) const { return strcmp(a, b) < 0; }
+    };
+    map<const char*, RollingSamples, NameLess> samples;
+
+    friend struct ThreadBufferOwner;
+};
+
+// Records the time between its construction and destruction under a name. Use PROFILE_SCOPE.
+class ProfileScope
+{
+public:
+    inline ProfileScope(const char* _name) : name(_name), start(Profiler::now()) {}
+    inline ~ProfileScope() { Profiler::get().record(name, start, Profiler::now()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_COLLECT()
+
+#endif
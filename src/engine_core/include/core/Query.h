@@ -14,7 +14,7 @@ class Query
 {
 public:
     // Constructs a query initially containing all items T in the provided world.
-    Query<T>(const hash_set<T>& _items) : items(_items) {}
+    Query(const hash_set<T>& _items) : items(_items) {}
 
     Query<T>& filter(function<bool(T)> predicate) {
         filters.push_back(predicate);
@@ -116,6 +116,7 @@ public:
         if(!filters.empty()) {
             apply();
         }
+        items.reserve(items.size() + other.items.size());
         items.insert(other.begin(), other.end());
         return *this;
     }
@@ -128,14 +129,26 @@ public:
         if(!filters.empty()) {
             apply();
         }
-        hash_set<T> result;
-
-        set_intersection(
-            items.begin(), items.end(),
-            other.items.begin(), other.items.end(),
-            inserter(result, result.end())
-        );
-        items = move(result);
+        if(items.size() <= other.items.size()) {
+            // Probe the larger set with each of our items, erasing in place.
+            for(auto it = items.begin(); it != items.end();) {
+                if(other.items.find(*it) == other.items.end()) {
+                    it = items.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        } else {
+            // The other set is smaller, so probe our items with it instead.
+            hash_set<T> result;
+            result.reserve(other.items.size());
+            for(const T& t : other.items) {
+                if(items.find(t) != items.end()) {
+                    result.insert(t);
+                }
+            }
+            items = move(result);
+        }
         return *this;
     }
     // Takes the intersection of the two queries (mutating the left Query).
@@ -147,14 +160,19 @@ public:
         if(!filters.empty()) {
             apply();
         }
-        hash_set<T> result;
-
-        set_difference(
-            items.begin(), items.end(),
-            other.items.begin(), other.items.end(),
-            inserter(result, result.end())
-        );
-        items = move(result);
+        if(items.size() <= other.items.size()) {
+            for(auto it = items.begin(); it != items.end();) {
+                if(other.items.find(*it) != other.items.end()) {
+                    it = items.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        } else {
+            for(const T& t : other.items) {
+                items.erase(t);
+            }
+        }
         return *this;
     }
     // Takes the difference of the two queries (mutating the left Query).
@@ -162,38 +180,18 @@ public:
         return left -= right;
     }
 
-    typename hash_set<T>::iterator begin() const {
+    typename hash_set<T>::const_iterator begin() const {
         return items.begin();
     }
-    typename hash_set<T>::iterator end() const {
+    typename hash_set<T>::const_iterator end() const {
         return items.end();
     }
 private:
     hash_set<T> items; // The set of items currently in the query
     vector<function<bool(T)>> filters; // The filters that are queued to be applied to the vector.
 
-    Query<T>() {}
+    Query() {}
 
     template<typename U>
     friend class Query;
 };
-
-template<typename T>
-bool filterByType(shared_ptr<Component> component) {
-    return component->getTypeId() == get_id(T);
-}
-
-shared_ptr<Entity> mapToOwner(shared_ptr<Component> component);
-
-template<typename T>
-shared_ptr<T> mapToComponent(shared_ptr<Entity> entity)
-{
-    return entity ? entity->findComponent<T>() : nullptr;
-}
-
-template<typename T>
-shared_ptr<T> mapToSibling(shared_ptr<Component> component)
-{
-    shared_ptr<Entity> owner = component->getOwner();
-    return owner ? owner->findComponent<T>() : nullptr;
-}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "std.h"
+
+#include <cstdint>
+
+/*
+Accumulates a 64-bit FNV-1a hash of simulation state, for checking that two runs stayed in lockstep.
+Values are hashed by their bytes, so only add types without padding, and add floats as they are (so that -0 and 0
+hash differently, just as they could diverge later).
+*/
+class StateHasher
+{
+public:
+    inline void addBytes(const void* data, size_t size) {
+        const uchar* bytes = static_cast<const uchar*>(data);
+        for(size_t i = 0; i < size; i++) {
+            value ^= bytes[i];
+            value *= 1099511628211ull;
+        }
+    }
+    template<typename T>
+    inline void add(const T& data) {
+        addBytes(&data, sizeof(T));
+    }
+
+    inline uint64_t getValue() const { return value; }
+private:
+    uint64_t value = 14695981039346656037ull;
+};
@@ -28,9 +28,43 @@ public:
     inline shared_ptr<World> getWorld() const {
         return world.lock();
     }
+
+    /*
+    Systems that run on the main thread (e.g. to own a GL context) are never scheduled on a worker,
+    and always run in priority order relative to each other.
+    */
+    bool mainThreadOnly = false;
+
+    /*
+    Declares the component types this system reads and writes, so the world can run it alongside systems it does not
+    conflict with. A system that declares nothing is exclusive: it runs alone, and may add or remove entities and
+    components. Systems that declare access must record structural changes into getWorld()->getCommandBuffer().
+    Declare access before adding the system to a world.
+    */
+    inline void declareAccess(vector<uint> _readTypes, vector<uint> _writeTypes) {
+        readTypes = move(_readTypes);
+        writeTypes = move(_writeTypes);
+        declaredAccess = true;
+    }
+    inline bool isExclusive() const { return !declaredAccess; }
+    inline const vector<uint>& getReadTypes() const { return readTypes; }
+    inline const vector<uint>& getWriteTypes() const { return writeTypes; }
+
+    /*
+    The world change tick this system's last frameTick or gameplayTick ran in, or 0 if it has not run yet.
+    Filter components with wasChangedSince(getLastFrameTick()) to only process what changed since then.
+    */
+    inline uint getLastFrameTick() const { return lastFrameTick; }
+    inline uint getLastGameplayTick() const { return lastGameplayTick; }
 private:
     weak_ptr<World> world; // The world that this system manages.
     bool initialized = false; // Has this system been initialized.
+    bool declaredAccess = false; // Has this system declared its component access.
+    vector<uint> readTypes; // The component types this system reads.
+    vector<uint> writeTypes; // The component types this system writes.
+    uint lastFrameTick = 0; // The change tick of the last completed frameTick.
+    uint lastGameplayTick = 0; // The change tick of the last completed gameplayTick.
+    const char* profileName = nullptr; // The name the system's ticks are profiled under. Set by World::addSystem.
 
     friend class World;
 };
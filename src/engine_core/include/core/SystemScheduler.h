@@ -0,0 +1,39 @@
+#pragma once
+
+#include "std.h"
+
+#include <functional>
+
+class System;
+class JobSystem;
+
+/*
+Runs the systems of a world, respecting their declared component access.
+Two systems conflict if either is exclusive, both are main thread only, or one writes a type the other uses.
+Conflicting systems run in priority order; all others may run at the same time on the job system's workers.
+*/
+class SystemScheduler
+{
+public:
+    // Marks the dependency graph as stale. It is rebuilt on the next run.
+    inline void invalidate() { dirty = true; }
+
+    /*
+    Calls fcn on every system. systems must be sorted by decreasing priority.
+    Without a job system the systems run one after another on the calling thread.
+    */
+    void run(const vector<shared_ptr<System>>& systems, JobSystem* jobs, const function<void(System&)>& fcn);
+
+    static bool conflicts(const System& a, const System& b);
+private:
+    struct Node
+    {
+        vector<uint> dependents; // The systems that must wait for this one.
+        uint dependencyCount = 0; // The number of systems this one must wait for.
+    };
+
+    void build(const vector<shared_ptr<System>>& systems);
+
+    vector<Node> nodes; // The dependency graph, one node per system.
+    bool dirty = true; // Does the graph need to be rebuilt.
+};
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "std.h"
+#include "core/Pool.h"
+
+#include <coroutine>
+#include <functional>
+
+class TaskScheduler;
+struct TaskPromise;
+
+/*
+A gameplay coroutine. Write a function that returns Task and co_awaits nextGameplayTick(), seconds(t), until(...) or
+allOf(...), then hand the result to World::startTask. Nothing runs until the task is started.
+Frames come from size class pools in the world's PoolSet (see TaskFramePoolScope) and destroy themselves when the
+coroutine returns. Tasks still suspended when their world is destroyed are destroyed with it, so a task should refer to
+its world by reference rather than a shared_ptr.
+*/
+class Task
+{
+public:
+    typedef TaskPromise promise_type;
+
+    Task() {}
+    Task(Task&& other) noexcept : handle(other.handle) {
+        other.handle = nullptr;
+    }
+    Task& operator=(Task&& other) noexcept;
+    ~Task();
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    // Gives up ownership of the unstarted coroutine to whoever runs it.
+    inline coroutine_handle<TaskPromise> release() {
+        coroutine_handle<TaskPromise> released = handle;
+        handle = nullptr;
+        return released;
+    }
+    inline bool isValid() const { return (bool)handle; }
+private:
+    explicit Task(coroutine_handle<TaskPromise> _handle) : handle(_handle) {}
+
+    coroutine_handle<TaskPromise> handle;
+
+    friend struct TaskPromise;
+};
+
+/*
+Draws the frames of tasks created on this thread from the pool set while in scope. Worlds install their pools while
+ticking, so tasks created by systems and other tasks live in their world's pools; frames created anywhere else come
+from a shared set. Every frame keeps its set alive, so frames may safely outlive the world or static destruction.
+*/
+class TaskFramePoolScope
+{
+public:
+    TaskFramePoolScope(PoolSet* pools);
+    ~TaskFramePoolScope();
+
+    TaskFramePoolScope(const TaskFramePoolScope&) = delete;
+    TaskFramePoolScope& operator=(const TaskFramePoolScope&) = delete;
+private:
+    PoolSet* previous;
+};
+
+// Resumes the task waiting on allOf once the last of its children returns.
+struct TaskJoin
+{
+    size_t remaining = 0;
+    coroutine_handle<> parent;
+};
+
+struct TaskPromise
+{
+    TaskScheduler* scheduler = nullptr; // Set once the task is started.
+    TaskPromise* previousLive = nullptr; // The scheduler's list of started tasks.
+    TaskPromise* nextLive = nullptr;
+    TaskPromise* nextWaiting = nullptr; // The queue the task waits in, if it is suspended on the scheduler.
+    uint64_t wakeTick = 0; // The tick a task waiting on the timer wheel resumes on.
+    bool (*poll)(void*) = nullptr; // Says whether a task waiting on a condition can resume.
+    void* pollContext = nullptr;
+    TaskJoin* join = nullptr; // The allOf this task is a child of, if any.
+
+    ~TaskPromise();
+
+    Task get_return_object() {
+        return Task(coroutine_handle<TaskPromise>::from_promise(*this));
+    }
+    suspend_always initial_suspend() noexcept { return {}; }
+    // Destroys the frame, then resumes the parent if this was the last child it was waiting on.
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept { return false; }
+        coroutine_handle<> await_suspend(coroutine_handle<TaskPromise> handle) noexcept;
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { throw; }
+
+    static void* operator new(size_t size);
+    static void operator delete(void* frame, size_t size);
+
+    inline coroutine_handle<TaskPromise> getHandle() {
+        return coroutine_handle<TaskPromise>::from_promise(*this);
+    }
+};
+
+// An intrusive FIFO of suspended tasks.
+struct TaskQueue
+{
+    TaskPromise* head = nullptr;
+    TaskPromise* tail = nullptr;
+
+    inline void push(TaskPromise* task) {
+        task->nextWaiting = nullptr;
+        (tail ? tail->nextWaiting : head) = task;
+        tail = task;
+    }
+    inline TaskPromise* pop() {
+        TaskPromise* task = head;
+        if(task) {
+            head = task->nextWaiting;
+            tail = head ? tail : nullptr;
+            task->nextWaiting = nullptr;
+        }
+        return task;
+    }
+    // Empties the queue, returning what it held.
+    inline TaskQueue take() {
+        TaskQueue taken = *this;
+        head = tail = nullptr;
+        return taken;
+    }
+};
+
+/*
+Runs the tasks of a world. Each update advances one tick and resumes, in order, newly started tasks, tasks whose timer
+expired on this tick and tasks whose condition now holds.
+Timers live in a hashed timer wheel, so suspending and waking a task are O(1). A timer further away than the wheel
+is long stays in its slot and is skipped each time the wheel comes around.
+*/
+class TaskScheduler
+{
+public:
+    TaskScheduler() {}
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Queues the task to start on the next update. Safe to call from any thread, including from systems.
+    void start(Task task);
+    // Advances a tick and resumes the tasks that are due. delta is the length of a tick in seconds.
+    void update(float delta);
+
+    // Links a task into the scheduler and runs it until it first suspends. Only call while updating.
+    void run(coroutine_handle<TaskPromise> handle);
+    // Suspends the task until the provided number of ticks (at least one) have passed.
+    void waitTicks(TaskPromise& task, uint64_t ticks);
+    // Suspends the task until poll(context) returns true. Conditions are checked once per tick.
+    void waitUntil(TaskPromise& task, bool (*poll)(void*), void* context);
+
+    // The number of ticks the scheduler has run.
+    inline uint64_t getTick() const { return tick; }
+    // The length of the last tick, used to turn durations into ticks.
+    inline float getTickDelta() const { return tickDelta; }
+    // The number of started tasks that have not returned.
+    inline size_t getLiveCount() const { return liveCount; }
+
+    // The number of slots in the timer wheel.
+    static const size_t WHEEL_SIZE = 256;
+private:
+    void unlink(TaskPromise& task);
+
+    uint64_t tick = 0;
+    float tickDelta = 1.0f / 60.0f;
+    TaskPromise* live = nullptr; // Every started task that has not returned.
+    size_t liveCount = 0;
+    TaskQueue wheel[WHEEL_SIZE]; // Tasks waiting on a timer, by wake tick modulo the wheel size.
+    TaskQueue polling; // Tasks waiting on a condition.
+    vector<coroutine_handle<TaskPromise>> started; // Tasks to run on the next update.
+    SpinLock startLock; // Guards started.
+
+    friend struct TaskPromise;
+};
+
+// Suspends the task for a number of gameplay ticks.
+struct TicksAwaiter
+{
+    uint64_t ticks;
+
+    inline bool await_ready() const { return ticks == 0; }
+    inline void await_suspend(coroutine_handle<TaskPromise> handle) {
+        handle.promise().scheduler->waitTicks(handle.promise(), ticks);
+    }
+    inline void await_resume() {}
+};
+
+// Suspends the task until the next gameplay tick.
+inline TicksAwaiter nextGameplayTick() {
+    return TicksAwaiter{1};
+}
+// Suspends the task for a number of gameplay ticks. 0 does not suspend.
+inline TicksAwaiter ticks(uint64_t count) {
+    return TicksAwaiter{count};
+}
+
+// Suspends the task for a duration, rounded up to whole gameplay ticks.
+struct SecondsAwaiter
+{
+    float duration;
+
+    inline bool await_ready() const { return duration <= 0; }
+    void await_suspend(coroutine_handle<TaskPromise> handle);
+    inline void await_resume() {}
+};
+
+inline SecondsAwaiter seconds(float duration) {
+    return SecondsAwaiter{duration};
+}
+
+// Suspends the task until the predicate returns true. The predicate is checked once per gameplay tick.
+struct UntilAwaiter
+{
+    function<bool()> predicate;
+
+    inline bool await_ready() { return predicate(); }
+    inline void await_suspend(coroutine_handle<TaskPromise> handle) {
+        handle.promise().scheduler->waitUntil(handle.promise(), &UntilAwaiter::poll, this);
+    }
+    inline void await_resume() {}
+private:
+    static bool poll(void* context) {
+        return static_cast<UntilAwaiter*>(context)->predicate();
+    }
+};
+
+inline UntilAwaiter until(function<bool()> predicate) {
+    return UntilAwaiter{move(predicate)};
+}
+
+// Starts every child immediately, and suspends the task until all of them have returned.
+class AllOfAwaiter
+{
+public:
+    AllOfAwaiter(vector<Task> _tasks) : tasks(move(_tasks)) {}
+
+    inline bool await_ready() const { return tasks.empty(); }
+    bool await_suspend(coroutine_handle<TaskPromise> handle);
+    inline void await_resume() {}
+private:
+    vector<Task> tasks;
+    TaskJoin join;
+};
+
+inline AllOfAwaiter allOf(vector<Task> tasks) {
+    return AllOfAwaiter(move(tasks));
+}
+template<typename... Ts>
+AllOfAwaiter allOf(Task first, Ts... rest)
+{
+    vector<Task> tasks;
+    tasks.reserve(1 + sizeof...(rest));
+    tasks.push_back(move(first));
+    (void)initializer_list<int>{(tasks.push_back(move(rest)), 0)...};
+    return AllOfAwaiter(move(tasks));
+}
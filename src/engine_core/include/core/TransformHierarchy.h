@@ -0,0 +1,107 @@
+#pragma once
+
+#include "std.h"
+#include "components/Transform.h"
+#include "core/JobSystem.h"
+#include "core/TransformKernels.h"
+
+/*
+A flat transform hierarchy for large numbers of nodes that do not need to be components, such as skeleton bones.
+Nodes are stored as parallel arrays sorted by depth, so every parent comes before its children, and update computes
+the world transform of every dirty node (and its descendants) in one linear pass over the depth levels, with the batch
+kernels from core/TransformKernels.h. The transforms are stored as TransformArrays, so the kernels load the local
+transforms and store the world transforms contiguously, and only gather the parents.
+Node ids are stable. Reparenting, adding and removing nodes re-sort the arrays on the next update.
+*/
+class TransformHierarchy
+{
+public:
+    static constexpr uint NO_PARENT = (uint)-1;
+
+    // Adds a node and returns its id. The world transform is valid after the next update.
+    uint addNode(const TransformData& local = TransformData(), uint parent = NO_PARENT);
+    // Removes the node. Its children are attached to the root, keeping their local transforms. O(n) in the nodes.
+    void removeNode(uint node);
+
+    /*
+    Replaces the parent of the node (NO_PARENT attaches it to the root). As with Transform::setParent, a parent that
+    would create a cycle attaches the node to the root instead.
+    */
+    void setParent(uint node, uint parent);
+    inline uint getParent(uint node) const {
+        return parents[node];
+    }
+
+    void setLocalTransform(uint node, const TransformData& local);
+    inline TransformData getLocalTransform(uint node) const {
+        return localArrays().get(slots[node]);
+    }
+    // The world transform as of the last update.
+    inline TransformData getWorldTransform(uint node) const {
+        return worldArrays().get(slots[node]);
+    }
+    inline const mat4& getWorldMatrix(uint node) const {
+        return worldMatrices[slots[node]];
+    }
+
+    /*
+    Computes the world transform of every node that moved since the last update.
+    With a job system, each depth level is split into ranges of at least grainSize nodes and run in parallel.
+    */
+    void update(JobSystem* jobSystem = nullptr, size_t grainSize = 0);
+
+    // The number of nodes in the hierarchy.
+    inline size_t size() const {
+        return nodeCount;
+    }
+private:
+    static constexpr uint FREE = (uint)-1;
+
+    // Sorts the arrays by depth and rebuilds the parent slots and depth levels.
+    void sortByDepth();
+    // Computes the world transforms of the dirty nodes in the slots [first, last), which must share a depth.
+    void updateRange(size_t first, size_t last);
+    // Marks the slot dirty if its parent is, and returns whether it is dirty.
+    inline bool propagateDirty(size_t slot) {
+        uint parent = parentSlots[slot];
+        if(parent != NO_PARENT && dirty[parent]) {
+            dirty[slot] = 1;
+        }
+        return dirty[slot] != 0;
+    }
+    inline TransformArrays localArrays() { return makeArrays(localFields); }
+    inline ConstTransformArrays localArrays() const { return makeArrays(localFields); }
+    inline TransformArrays worldArrays() { return makeArrays(worldFields); }
+    inline ConstTransformArrays worldArrays() const { return makeArrays(worldFields); }
+    static inline TransformArrays makeArrays(vector<float>* fields) {
+        TransformArrays arrays;
+        for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+            arrays.fields[field] = fields[field].data();
+        }
+        return arrays;
+    }
+    static inline ConstTransformArrays makeArrays(const vector<float>* fields) {
+        ConstTransformArrays arrays;
+        for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+            arrays.fields[field] = fields[field].data();
+        }
+        return arrays;
+    }
+
+    // Indexed by node id.
+    vector<uint> slots; // The slot of each node, or FREE if the id is free.
+    vector<uint> parents; // The parent node of each node.
+    vector<uint> freeNodes; // Node ids that can be reused.
+
+    // Indexed by slot, sorted by depth.
+    vector<uint> nodes; // The node in each slot, or FREE if the node was removed since the last sort.
+    vector<uint> parentSlots; // The slot of each node's parent, or NO_PARENT.
+    vector<float> localFields[TRANSFORM_FIELDS]; // The local transforms, as TransformArrays.
+    vector<float> worldFields[TRANSFORM_FIELDS]; // The world transforms as of the last update, as TransformArrays.
+    vector<mat4> worldMatrices;
+    vector<uchar> dirty; // Does the slot's world transform need recomputing.
+
+    size_t nodeCount = 0;
+    vector<size_t> levelStarts; // The first slot of each depth, followed by the number of slots.
+    bool needsSort = false; // Has the structure changed since the arrays were sorted.
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "std.h"
+#include "components/Transform.h"
+
+/*
+Batch versions of the TransformData operations, for the inner loops that process many transforms at once.
+The kernels use the widest instruction set the CPU supports (AVX2 or SSE2 on x86, NEON on ARM64) and fall back to
+scalar code. Results agree with the scalar TransformData functions to within float rounding.
+The output may alias an input of the same type.
+
+Each operation takes either arrays of TransformData, which the vector kernels have to gather field by field, or
+TransformArrays, which they load and store contiguously. Prefer TransformArrays for data the caller lays out itself.
+*/
+
+// The number of floats in a transform: translation x, y, z, rotation w, x, y, z and scale x, y, z, in that order.
+const size_t TRANSFORM_FIELDS = 10;
+
+/*
+Transforms stored as one array per float (see TRANSFORM_FIELDS for the order), so that consecutive transforms are
+consecutive in every array. Only points at the arrays; the caller owns them.
+Float is float for outputs and const float for inputs. Mutable arrays convert to const ones.
+*/
+template<typename Float>
+struct BasicTransformArrays
+{
+    Float* fields[TRANSFORM_FIELDS];
+
+    BasicTransformArrays() : fields() {}
+    template<typename Other>
+    BasicTransformArrays(const BasicTransformArrays<Other>& other) {
+        for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+            fields[field] = other.fields[field];
+        }
+    }
+
+    // The arrays starting at the transform with the provided index.
+    inline BasicTransformArrays offset(size_t index) const {
+        BasicTransformArrays shifted = *this;
+        for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+            shifted.fields[field] += index;
+        }
+        return shifted;
+    }
+    inline TransformData get(size_t index) const {
+        return TransformData(
+            vec3(fields[0][index], fields[1][index], fields[2][index]),
+            quat(fields[3][index], fields[4][index], fields[5][index], fields[6][index]),
+            vec3(fields[7][index], fields[8][index], fields[9][index]));
+    }
+    inline void set(size_t index, const TransformData& transform) const {
+        const float values[TRANSFORM_FIELDS] = {
+            transform.translation.x, transform.translation.y, transform.translation.z,
+            transform.rotation.w, transform.rotation.x, transform.rotation.y, transform.rotation.z,
+            transform.scale.x, transform.scale.y, transform.scale.z
+        };
+        for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+            fields[field][index] = values[field];
+        }
+    }
+};
+typedef BasicTransformArrays<float> TransformArrays;
+typedef BasicTransformArrays<const float> ConstTransformArrays;
+
+enum class SimdLevel : uchar
+{
+    Scalar, SSE2, AVX2, NEON
+};
+
+string to_string(SimdLevel level);
+
+// The widest instruction set the kernels can use on this machine.
+SimdLevel getSupportedSimdLevel();
+// The instruction set the kernels currently use.
+SimdLevel getSimdLevel();
+/*
+Makes the kernels use the provided instruction set, e.g. to compare them against the scalar path.
+Returns false and changes nothing if the machine or build does not support it. Not safe to call while kernels run.
+*/
+bool setSimdLevel(SimdLevel level);
+
+// out[i] = lhs[i] * rhs[i].
+void composeTransforms(const TransformData* lhs, const TransformData* rhs, TransformData* out, size_t count);
+void composeTransforms(const ConstTransformArrays& lhs, const ConstTransformArrays& rhs, const TransformArrays& out,
+    size_t count);
+/*
+out[i] = lhs[lhsIndices[i]] * rhs[i], e.g. to compose children with the world transforms of their parents.
+The lhs transforms are gathered, so they must not overlap the output, although both may be parts of the same arrays.
+*/
+void composeTransforms(const ConstTransformArrays& lhs, const uint* lhsIndices, const ConstTransformArrays& rhs,
+    const TransformArrays& out, size_t count);
+// out[i] = transforms[i].inverse().
+void invertTransforms(const TransformData* transforms, TransformData* out, size_t count);
+// out[i] = transforms[i].toMat4().
+void transformsToMat4(const TransformData* transforms, mat4* out, size_t count);
+void transformsToMat4(const ConstTransformArrays& transforms, mat4* out, size_t count);
+// out[i] = transform.transformPoint(points[i]).
+void transformPoints(const TransformData& transform, const vec3* points, vec3* out, size_t count);
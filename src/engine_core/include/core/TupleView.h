@@ -0,0 +1,120 @@
+#pragma once
+
+#include "std.h"
+#include "core/ComponentStorage.h"
+#include "core/Entity.h"
+
+#include <tuple>
+
+/*
+Walks the entities that have a component of every type in Ts, yielding a reference to one component of each type.
+Only the storage of the rarest type is walked; every candidate is checked against its owner's type mask and the
+other components are looked up on the owner in O(1), so nothing is hashed, cast dynamically or refcounted.
+
+An entity with several components of the walked type is visited once per component. For the other types, the
+first component of that type is used.
+Components of a non-const type are marked changed (see Component::markChanged) as they are yielded, so ask for
+const T when only reading T.
+As with ComponentRange, none of the types may be added or removed while the view is being iterated.
+*/
+template<typename... Ts>
+class TupleView
+{
+    static_assert(sizeof...(Ts) > 0, "TupleView needs at least one component type.");
+public:
+    typedef tuple<Ts&...> value_type;
+
+    class iterator
+    {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = TupleView::value_type;
+        using reference = value_type;
+        using difference_type = ptrdiff_t;
+        using pointer = value_type*;
+
+        iterator(const TupleView* _view, Component* const* _it) : view(_view), it(_it), owner(nullptr) { skip(); }
+
+        inline value_type operator*() const { return value_type(view->template getMember<Ts>(*it, owner)...); }
+        inline iterator& operator++() { ++it; skip(); return *this; }
+        inline bool operator==(const iterator& other) const { return it == other.it; }
+        inline bool operator!=(const iterator& other) const { return it != other.it; }
+    private:
+        // Advances until a component whose owner has every type is found or the end is reached.
+        inline void skip() {
+            for(; it != view->first + view->count; ++it) {
+                owner = view->findOwner(**it);
+                if(owner) {
+                    return;
+                }
+            }
+        }
+
+        const TupleView* view;
+        Component* const* it;
+        const Entity* owner; // The owner of the component at the current position.
+    };
+
+    TupleView() : first(nullptr), count(0) {}
+    // Picks the smallest storage out of the storages indexed by type id.
+    TupleView(const vector<ComponentStorage>& storages) : first(nullptr), count(0), mask(makeComponentMask<Ts...>())
+    {
+        const ComponentStorage* smallest = nullptr;
+        for(uint type : { getComponentTypeId<Ts>()... }) {
+            // No component of this type was ever added, so no entity can match.
+            if(type >= storages.size()) {
+                return;
+            }
+            if(!smallest || storages[type].size() < smallest->size()) {
+                smallest = &storages[type];
+            }
+        }
+        first = smallest->data();
+        count = smallest->size();
+    }
+
+    inline iterator begin() const { return iterator(this, first); }
+    inline iterator end() const { return iterator(this, first + count); }
+    // The number of candidates that are walked. An upper bound on the number of matches.
+    inline size_t size() const { return count; }
+
+    // Calls fcn(Ts&...) for every match.
+    template<typename F>
+    void each(const F& fcn) const
+    {
+        eachInRange(0, count, fcn);
+    }
+    // Calls fcn(Ts&...) for every match among the candidates in [firstIndex, lastIndex), so ranges can be split across threads.
+    template<typename F>
+    void eachInRange(size_t firstIndex, size_t lastIndex, const F& fcn) const
+    {
+        for(size_t i = firstIndex; i < lastIndex; i++) {
+            if(const Entity* owner = findOwner(*first[i])) {
+                fcn(getMember<Ts>(first[i], owner)...);
+            }
+        }
+    }
+private:
+    // Returns the owner of the candidate if it has every type, or nullptr.
+    inline const Entity* findOwner(const Component& candidate) const {
+        const Entity* owner = candidate.getOwnerHandle().get();
+        return owner && owner->hasComponents(mask) ? owner : nullptr;
+    }
+    /*
+    The candidate itself if it is a T, so every component of the walked type is visited. Otherwise the owner's T.
+    Marks the member changed unless T is const.
+    */
+    template<typename T>
+    inline T& getMember(Component* candidate, const Entity* owner) const {
+        uint type = getComponentTypeId<T>();
+        T* member = static_cast<T*>(candidate->getTypeId() == type ? candidate : owner->getComponentByType(type));
+        if constexpr(!is_const<T>::value) {
+            member->markChanged();
+        }
+        return *member;
+    }
+
+    Component* const* first; // The first candidate in the walked storage.
+    size_t count; // The number of candidates.
+    ComponentMask mask; // The types an owner needs to match.
+};
@@ -3,23 +3,59 @@
 
 #include "std.h"
 
+#include <functional>
+#include <cstdint>
+
 class Entity;
 class Component;
 class World;
+class JobSystem;
 
 class Universe
 {
 public:
+    /*
+    Starts a job system with the provided number of workers, which the systems of every world are scheduled on.
+    With zero workers, systems run on the thread that calls tick.
+    */
+    Universe(uint workerThreads = getDefaultWorkerThreads());
+    ~Universe();
+
     // The rate at which gameplay ticks should be issued (ticks / second).
     float gameplayRate = 50;
     // The maximum number of gameplay ticks that can be issued before we must skip.
     int maxGameplayTicksPerFrame = 10;
+    /*
+    Ticks the worlds concurrently on the job system instead of one after another. Every world runs its gameplay ticks,
+    then all worlds wait for each other before running their frame ticks. Worlds must not share any state.
+    Worlds with main thread systems are always ticked on the thread that calls tick.
+    */
+    bool parallelWorlds = false;
 
     /*
     Process ticking based on the delta time. Gameplay ticks are issued at a fixed rate,
     frame ticks are issued once per tick. Delta time is in seconds.
     */
     void tick(float deltaTime);
+    /*
+    Runs count gameplay ticks back to back, as fast as possible and with no frame ticks, for headless simulation.
+    Nothing is skipped, and the clocks advance as if the time had passed.
+    */
+    void runTicks(uint64_t count);
+
+    // The number of gameplay ticks that have been run.
+    inline uint64_t getTickCount() const {
+        return gameplayTicks;
+    }
+    // The gameplay time that has been simulated in seconds, not counting skipped time.
+    inline double getSimulatedTime() const {
+        return simulatedTime;
+    }
+    /*
+    Hashes the tick count and the state of every world, in the order the worlds were added.
+    Two runs of the same simulation with the same inputs produce the same hash at the same tick.
+    */
+    uint64_t hashState() const;
 
     /*
     Creates and adds a default world to the universe.
@@ -39,10 +75,29 @@ public:
     After removeWorld, you are free to add this world back to the universe or do whatever.
     */
     shared_ptr<World> removeWorld(weak_ptr<World> world);
+
+    inline JobSystem* getJobSystem() const {
+        return jobSystem.get();
+    }
+
+    static uint getDefaultWorkerThreads();
 private:
+    // Runs the gameplay ticks on every world and advances the gameplay clocks.
+    void runGameplayTicks(uint64_t count, double delta);
+    // Runs the gameplay ticks of a world and records how long they took.
+    static void runGameplayTicks(World& world, uint64_t ticks, float delta);
+    // Runs the frame tick of a world and records how long it took.
+    static void runFrameTick(World& world, float delta);
+    // Runs fcn on every world, spreading worlds without main thread systems across the job system.
+    void forEachWorldInParallel(const function<void(World&)>& fcn);
+
+    unique_ptr<JobSystem> jobSystem; // The workers shared by every world in this universe.
     vector<shared_ptr<World>> worlds; // The worlds that this universe owns.
 
-    float totalTime = 0; // The total time ticked.
-    float gameplayTime = 0; // The gameplay time that has been processed (including skipped time).
-    float skippedTime = 0; // The total skipped time.
+    // Clocks are doubles, so they keep sub-millisecond precision over months of uptime.
+    double totalTime = 0; // The total time ticked.
+    double gameplayTime = 0; // The gameplay time that has been processed (including skipped time).
+    double skippedTime = 0; // The total skipped time.
+    double simulatedTime = 0; // The gameplay time that has been processed (excluding skipped time).
+    uint64_t gameplayTicks = 0; // The number of gameplay ticks that have been run.
 };
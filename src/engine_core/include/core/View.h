@@ -0,0 +1,84 @@
+#pragma once
+
+#include "std.h"
+#include "core/Component.h"
+#include "core/ComponentStorage.h"
+
+class Entity;
+
+/*
+A persistent query registered on a World.
+A view contains every component whose type is one of its types and whose owner also has a component of every required type.
+The world updates membership as components and entities are added and removed, so reading a view costs nothing
+on frames without structural changes.
+*/
+class View
+{
+public:
+    // Returns a range over the members of the view, viewed as T. T must be a base of every type in the view.
+    template<typename T>
+    ComponentRange<T> getComponents() const {
+        return ComponentRange<T>(members.data(), members.size());
+    }
+
+    inline bool contains(const Component* component) const {
+        return indices.find(component) != indices.end();
+    }
+    inline size_t size() const { return members.size(); }
+    inline bool empty() const { return members.empty(); }
+
+    /*
+    The components that joined or left the view since the last call to clearChanges.
+    Removed components may already be destroyed, so these hold handles. A component that joins and then leaves
+    between calls appears in neither list. Consumers should process removals before additions.
+    The lists are in no particular order.
+    */
+    inline const vector<Handle<Component>>& getAdded() const { return added; }
+    inline const vector<Handle<Component>>& getRemoved() const { return removed; }
+    // Forgets the recorded changes. Call this once the owner of the view has consumed them.
+    void clearChanges();
+
+    inline const vector<uint>& getTypes() const { return types; }
+    inline const vector<uint>& getRequiredTypes() const { return requiredTypes; }
+private:
+    View(vector<uint> _types, vector<uint> _requiredTypes);
+
+    inline bool isMemberType(uint type) const {
+        return memberMask.test(type);
+    }
+    inline bool isRequiredType(uint type) const {
+        return requiredMask.test(type);
+    }
+    // Does the owner of component have every required type, not counting the ignored component.
+    bool ownerMatches(const Component& component, const Component* ignored) const;
+
+    void insert(Component* component);
+    void erase(Component* component);
+
+    // Called by the world after a component enters it.
+    void onComponentAdded(Component* component);
+    /*
+    Called by the world before a component leaves it. The component is still attached to its owner: Entity notifies
+    the world before erasing the component from its table.
+    */
+    void onComponentRemoved(Component* component);
+
+    vector<uint> types; // The types of component that are members of this view.
+    vector<uint> requiredTypes; // The types the owner of a member must also have.
+    ComponentMask memberMask; // types as a mask.
+    ComponentMask requiredMask; // requiredTypes as a mask.
+    static constexpr size_t NOT_ADDED = (size_t)-1;
+
+    struct MemberIndex
+    {
+        size_t member; // The index in members.
+        size_t added; // The index in added, or NOT_ADDED if the member joined before the last clearChanges.
+    };
+
+    vector<Component*> members; // The members of this view, densely packed.
+    hash_map<const Component*, MemberIndex> indices; // Where each member is in members and added.
+    vector<Handle<Component>> added; // Components that joined since the last clearChanges.
+    vector<Handle<Component>> removed; // Components that left since the last clearChanges.
+
+    friend class World;
+};
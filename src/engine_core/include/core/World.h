@@ -3,18 +3,96 @@
 
 #include "std.h"
 #include "Query.h"
+#include "ComponentStorage.h"
+#include "OwnerJoin.h"
+#include "TupleView.h"
+#include "JobSystem.h"
+#include "View.h"
+#include "SystemScheduler.h"
+#include "CommandBuffer.h"
+#include "EventBus.h"
+#include "Task.h"
 
 class Entity;
 class System;
+class BudgetedSystem;
 
 class World : public enable_shared_from_this<World>
 {
 public:
+    World();
+    ~World();
+
     // Returns a query that can filter down entities in the world.
     Query<shared_ptr<Entity>> queryEntities();
     // Returns a query that can filter down components in the world.
     Query<shared_ptr<Component>> queryComponents(uint type);
+
+    /*
+    Returns a range over all components in the world with the provided type id, viewed as T.
+    This does not copy or refcount anything, so it should be preferred over queryComponents in systems.
+    */
+    template<typename T>
+    ComponentRange<T> getComponentsOfType(uint type = get_id(T)) const
+    {
+        return type < components.size() ? ComponentRange<T>(components[type]) : ComponentRange<T>();
+    }
+    /*
+    Returns a range over each component of type A paired with a component of type B on the same entity.
+    Use this instead of mapping every A to its sibling when only entities with both types are wanted.
+    */
+    template<typename A, typename B>
+    OwnerJoinRange<A, B> joinByOwner(uint typeA = get_id(A), uint typeB = get_id(B)) const
+    {
+        // No owner can have a B if there are none.
+        if(typeA >= components.size() || typeB >= components.size() || components[typeB].empty()) {
+            return OwnerJoinRange<A, B>();
+        }
+        return OwnerJoinRange<A, B>(components[typeA], typeB);
+    }
+    /*
+    Returns a view over the entities that have a component of every type in Ts.
+    Iterating yields tuple<Ts&...> with no refcounting. See TupleView.
+    */
+    template<typename... Ts>
+    TupleView<Ts...> view() const
+    {
+        return TupleView<Ts...>(components);
+    }
+    /*
+    Calls fcn(Ts&...) for every entity that has a component of every type in Ts.
+    Components of non-const types are marked changed, so declare the types that are only read as const.
+    */
+    template<typename... Ts, typename F>
+    void each(const F& fcn) const
+    {
+        view<Ts...>().each(fcn);
+    }
+    /*
+    Like each, but splits the entities into chunks of at least grainSize and runs them on the job system.
+    fcn must be safe to call for different entities at the same time. Runs serially if there is no job system.
+    */
+    template<typename... Ts, typename F>
+    void parallelEach(const F& fcn, size_t grainSize = 0) const
+    {
+        TupleView<Ts...> entities = view<Ts...>();
+        if(!jobSystem) {
+            entities.each(fcn);
+            return;
+        }
+        jobSystem->parallelFor(entities.size(), grainSize, [&entities, &fcn](size_t first, size_t last) {
+            entities.eachInRange(first, last, fcn);
+        });
+    }
     
+    /*
+    Registers a view over components of any of the types whose owners also have all of the required types.
+    The view is filled from the current contents of the world and kept up to date from then on.
+    */
+    shared_ptr<View> addView(vector<uint> types, vector<uint> requiredTypes = {});
+    // Stops maintaining the view. The view keeps its last contents.
+    void removeView(shared_ptr<View> view);
+
     /*
     Constructs an empty entity and returns a pointer to it.
     Do not store shared_ptrs to the entity afterwards.
@@ -39,6 +117,16 @@ public:
         addSystem(newSystem);
         return newSystem;
     }
+    // Creates the budgeted system as the provided type, gives it the per-frame budget and adds it as addSystem does.
+    template<class T>
+    shared_ptr<T> addBudgetedSystem(float budgetMilliseconds, float priority = 0)
+    {
+        shared_ptr<T> newSystem = make_shared<T>();
+        newSystem->budgetMilliseconds = budgetMilliseconds;
+        newSystem->priority = priority;
+        addSystem(newSystem);
+        return newSystem;
+    }
 
     /*
     Ticks once per frame.
@@ -55,17 +143,115 @@ public:
     void addComponent(shared_ptr<Component> component);
     void removeComponent(shared_ptr<Component> component);
 
+    /*
+    Returns the buffer that systems should record structural changes into while the world is ticking.
+    The buffer is applied at the end of every gameplay and frame tick, after all systems have run.
+    */
+    inline CommandBuffer& getCommandBuffer() {
+        return commands;
+    }
+    // Applies the recorded structural changes now. Must not be called from a system.
+    void flushCommands();
+
+    /*
+    Returns the events systems publish to each other. The bus swaps at the start of every gameplay tick, so events
+    published during a gameplay tick (or the frame ticks after it) are read during the next gameplay tick and the
+    frame ticks after that.
+    */
+    inline EventBus& getEventBus() {
+        return events;
+    }
+
+    /*
+    Starts a gameplay coroutine. Tasks run on the thread that ticks the world at the end of every gameplay tick, after
+    all systems, so they may change the world directly. A task first runs on the gameplay tick after it is started.
+    */
+    inline void startTask(Task task) {
+        tasks.start(move(task));
+    }
+    inline const TaskScheduler& getTaskScheduler() const {
+        return tasks;
+    }
+
+    /*
+    The current change tick. It advances at the start of every gameplay and frame tick, and components record it when
+    they are added or marked changed.
+    */
+    inline uint getChangeTick() const {
+        return changeTick;
+    }
+
+    // Returns usage statistics for the pools this world allocates entities, components and task frames from.
+    inline vector<PoolStats> getPoolStats() const {
+        return pools->getStats();
+    }
+
     inline hash_set<shared_ptr<Entity>> getEntities() const {
         return entities;
     }
     inline vector<shared_ptr<System>> getSystems() const {
         return systems;
     }
+    /*
+    Adds the state of every component in the world to the hasher. Types are visited in order of their stable ids and
+    components in storage order, so two runs that make the same changes in the same order hash the same. Which entity
+    owns each component is hashed too (see Component::hashIdentity).
+    */
+    void hashState(StateHasher& hasher) const;
+
+    // Does this world have any systems that must run on the main thread.
+    bool hasMainThreadSystems() const;
+
+    // How long the world spent ticking during the last Universe::tick.
+    struct TickTiming
+    {
+        uint gameplayTicks = 0; // The number of gameplay ticks that were run.
+        float gameplaySeconds = 0; // The total time spent in those gameplay ticks.
+        float frameSeconds = 0; // The time spent in the frame tick.
+    };
+    inline const TickTiming& getLastTickTiming() const {
+        return lastTickTiming;
+    }
+    // How far behind a budgeted system is on its work.
+    struct BudgetReport
+    {
+        shared_ptr<BudgetedSystem> system;
+        float budgetMilliseconds = 0; // The time the system may spend each frame.
+        float lastMilliseconds = 0; // The time the system spent during the last frame.
+        size_t backlog = 0; // The units of work still waiting.
+        float framesBehind = 0; // The frames it would take to clear the backlog at the recent rate.
+    };
+    // Returns a report for every budgeted system in the world, in priority order.
+    vector<BudgetReport> getBudgetReports() const;
+    // The job system systems are scheduled on, or nullptr if this world runs its systems serially.
+    inline JobSystem* getJobSystem() const {
+        return jobSystem;
+    }
 private:
+    // Initializes any systems that have not run yet, on the calling thread.
+    void initSystems();
+    // Grows storage to fit the provided number of extra entities and extra components of each type.
+    void reserve(size_t extraEntities, const vector<size_t>& extraComponents);
+
     hash_set<shared_ptr<Entity>> entities;
-    hash_map<uint, hash_set<shared_ptr<Component>>> components;
+    vector<ComponentStorage> components; // The components of each type, indexed by type id. Owned by their entities.
     vector<shared_ptr<System>> systems;
+    vector<shared_ptr<View>> views; // The views kept up to date by this world.
+    JobSystem* jobSystem = nullptr; // Provided by the universe that owns this world.
+    SystemScheduler scheduler;
+    TickTiming lastTickTiming; // Filled in by the universe that ticks this world.
+    uint changeTick = 0; // See getChangeTick. Only advanced between ticks, so systems can read it from any thread.
+    CommandBuffer commands; // Structural changes recorded by systems during a tick.
+    EventBus events;
+    /*
+    The pools entities, components and task frames in this world are allocated from.
+    Objects keep the pools alive, so the slabs are freed in bulk once the world and all of its objects are gone.
+    */
+    shared_ptr<PoolSet> pools;
+    // Declared last so suspended tasks are destroyed before the entities and systems they may refer to.
+    TaskScheduler tasks;
 
     friend class Universe;
     friend class Entity;
+    friend class CommandBuffer;
 };
@@ -9,6 +9,8 @@
 #include <unordered_set>
 #include <string>
 #include <memory>
+// <thread> declares this_thread::get_id, so it must be included before the get_id macro below.
+#include <thread>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
@@ -26,4 +28,7 @@ using hash_map = unordered_map<K, V>;
 template<typename T>
 using hash_set = unordered_set<T>;
 
-#define get_id(x) (uint)(typeid(x).hash_code())
+// Returns the dense id of the component type x. See core/ComponentType.h.
+#define get_id(x) getComponentTypeId<x>()
+
+#include "core/ComponentType.h"
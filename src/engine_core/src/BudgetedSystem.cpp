@@ -0,0 +1,35 @@
+#include "core/BudgetedSystem.h"
+
+#include <chrono>
+
+void BudgetedSystem::frameTick(float delta)
+{
+    auto start = chrono::steady_clock::now();
+    auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::duration<float, milli>(budgetMilliseconds));
+    size_t processed = 0;
+    bool exhausted = false;
+    while(chrono::steady_clock::now() < deadline) {
+        if(!processWork()) {
+            exhausted = true;
+            break;
+        }
+        processed++;
+    }
+    lastProcessed = processed;
+    lastMilliseconds = chrono::duration<float, milli>(chrono::steady_clock::now() - start).count();
+    // Frames that ran out of work say nothing about how fast the backlog can be cleared.
+    if(!exhausted) {
+        averageProcessed = averageProcessed == 0 ? (float)processed : averageProcessed * 0.9f + processed * 0.1f;
+    }
+}
+
+float BudgetedSystem::getFramesBehind() const
+{
+    size_t backlog = getBacklog();
+    if(backlog == 0) {
+        return 0;
+    }
+    // With no measured rate yet, assume the backlog takes at least one more frame.
+    return averageProcessed > 0 ? backlog / averageProcessed : 1.0f;
+}
@@ -0,0 +1,107 @@
+
+#include "core/CommandBuffer.h"
+#include "core/World.h"
+#include "core/Entity.h"
+#include "core/Component.h"
+
+shared_ptr<Entity> CommandBuffer::spawnEntity()
+{
+    shared_ptr<Entity> entity = makePooled<Entity>(pools);
+    entity->pools = pools;
+    addEntity(entity);
+    return entity;
+}
+
+void CommandBuffer::addEntity(shared_ptr<Entity> entity)
+{
+    record({ CommandType::AddEntity, move(entity), nullptr });
+}
+
+void CommandBuffer::removeEntity(shared_ptr<Entity> entity)
+{
+    record({ CommandType::RemoveEntity, move(entity), nullptr });
+}
+
+void CommandBuffer::addComponent(shared_ptr<Entity> entity, shared_ptr<Component> component)
+{
+    record({ CommandType::AddComponent, move(entity), move(component) });
+}
+
+void CommandBuffer::removeComponent(shared_ptr<Component> component)
+{
+    record({ CommandType::RemoveComponent, nullptr, move(component) });
+}
+
+void CommandBuffer::append(CommandBuffer& other)
+{
+    vector<Command> moved;
+    {
+        lock_guard<mutex> guard(other.lock);
+        moved.swap(other.commands);
+    }
+    lock_guard<mutex> guard(lock);
+    commands.reserve(commands.size() + moved.size());
+    for(Command& command : moved) {
+        commands.push_back(move(command));
+    }
+}
+
+bool CommandBuffer::empty() const
+{
+    lock_guard<mutex> guard(lock);
+    return commands.empty();
+}
+
+void CommandBuffer::record(Command command)
+{
+    lock_guard<mutex> guard(lock);
+    commands.push_back(move(command));
+}
+
+void CommandBuffer::apply(World& world)
+{
+    vector<Command> pending;
+    {
+        lock_guard<mutex> guard(lock);
+        pending.swap(commands);
+    }
+    if(pending.empty()) {
+        return;
+    }
+
+    // Count what will be added so the world only grows its storage once.
+    size_t addedEntities = 0;
+    vector<size_t> addedComponents(getComponentTypeCount(), 0);
+    for(const Command& command : pending) {
+        if(command.type == CommandType::AddEntity) {
+            addedEntities++;
+            for(const shared_ptr<Component>& component : command.entity->components) {
+                addedComponents[component->getTypeId()]++;
+            }
+        } else if(command.type == CommandType::AddComponent) {
+            addedComponents[command.component->getTypeId()]++;
+        }
+    }
+    world.reserve(addedEntities, addedComponents);
+
+    for(Command& command : pending) {
+        switch(command.type) {
+        case CommandType::AddEntity:
+            world.addEntity(command.entity);
+            break;
+        case CommandType::RemoveEntity:
+            world.removeEntity(command.entity);
+            break;
+        case CommandType::AddComponent:
+            command.entity->addComponent(command.component);
+            break;
+        case CommandType::RemoveComponent: {
+            Entity* owner = command.component->getOwnerHandle().get();
+            if(owner) {
+                owner->removeComponent(command.component);
+            }
+            break;
+        }
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#include "core/Component.h"
+#include "core/Entity.h"
+
+Component::Component(uint typeId)
+{
+    this->typeId = typeId;
+    getHandleTable<Component>().acquire(this, handle.index, handle.generation);
+}
+
+Component::~Component()
+{
+    getHandleTable<Component>().release(handle.index);
+}
+
+void Component::hashIdentity(StateHasher& hasher, const Component* component)
+{
+    hasher.add(component ? getStableComponentTypeId(component->typeId) : (uint)-1);
+    hasher.add(component ? component->storageIndex : (uint)-1);
+}
+
+shared_ptr<Entity> Component::getOwner() const
+{
+    Entity* ownerPtr = owner.get();
+    return ownerPtr ? ownerPtr->shared_from_this() : nullptr;
+}
@@ -0,0 +1,23 @@
+#include "core/ComponentStorage.h"
+
+void ComponentStorage::add(Component* component)
+{
+    if(contains(component)) {
+        return;
+    }
+    component->storageIndex = (uint)dense.size();
+    dense.push_back(component);
+}
+
+void ComponentStorage::remove(Component* component)
+{
+    if(!contains(component)) {
+        return;
+    }
+    uint index = component->storageIndex;
+    Component* last = dense.back();
+    dense[index] = last;
+    last->storageIndex = index;
+    dense.pop_back();
+    component->storageIndex = (uint)-1;
+}
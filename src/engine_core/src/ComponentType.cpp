@@ -0,0 +1,107 @@
+
+#include "core/ComponentType.h"
+
+#include <mutex>
+#include <cstring>
+
+struct ComponentTypeInfo
+{
+    string name;
+    uint stableId;
+};
+
+// Registration happens during static initialization of function locals, so the registry must be constructed on first use.
+static vector<ComponentTypeInfo>& getTypes()
+{
+    static vector<ComponentTypeInfo> types;
+    return types;
+}
+
+static mutex& getTypesLock()
+{
+    static mutex lock;
+    return lock;
+}
+
+string extractTypeName(const string& signature)
+{
+    string name;
+    // GCC and Clang: "... getTypeSignature() [with T = Name]" or "[T = Name]".
+    size_t start = signature.find("T = ");
+    if(start != string::npos) {
+        start += 4;
+        size_t end = signature.find_first_of(";]", start);
+        name = signature.substr(start, end - start);
+    } else {
+        // MSVC: "... getTypeSignature<class Name>(void)".
+        start = signature.find('<');
+        size_t end = signature.rfind('>');
+        name = start != string::npos && end != string::npos ? signature.substr(start + 1, end - start - 1) : signature;
+        for(const char* prefix : { "class ", "struct " }) {
+            if(name.compare(0, strlen(prefix), prefix) == 0) {
+                name = name.substr(strlen(prefix));
+            }
+        }
+    }
+    return name;
+}
+
+// 32-bit FNV-1a.
+static uint hashName(const string& name)
+{
+    uint hash = 2166136261u;
+    for(char c : name) {
+        hash ^= (uchar)c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint registerComponentType(const char* signature)
+{
+    lock_guard<mutex> guard(getTypesLock());
+    vector<ComponentTypeInfo>& types = getTypes();
+    if(types.size() >= MAX_COMPONENT_TYPES) {
+        throw "Too many component types. Increase MAX_COMPONENT_TYPES.";
+    }
+    ComponentTypeInfo info;
+    info.name = extractTypeName(signature);
+    info.stableId = hashName(info.name);
+    for(const ComponentTypeInfo& other : types) {
+        if(other.stableId == info.stableId) {
+            throw "Two component types have the same stable id.";
+        }
+    }
+    types.push_back(info);
+    return (uint)types.size() - 1;
+}
+
+uint getComponentTypeCount()
+{
+    lock_guard<mutex> guard(getTypesLock());
+    return (uint)getTypes().size();
+}
+
+const string& getComponentTypeName(uint typeId)
+{
+    lock_guard<mutex> guard(getTypesLock());
+    return getTypes()[typeId].name;
+}
+
+uint getStableComponentTypeId(uint typeId)
+{
+    lock_guard<mutex> guard(getTypesLock());
+    return getTypes()[typeId].stableId;
+}
+
+uint findComponentTypeByStableId(uint stableId)
+{
+    lock_guard<mutex> guard(getTypesLock());
+    vector<ComponentTypeInfo>& types = getTypes();
+    for(uint i = 0; i < types.size(); i++) {
+        if(types[i].stableId == stableId) {
+            return i;
+        }
+    }
+    return (uint)-1;
+}
@@ -3,15 +3,29 @@
 #include "core/Component.h"
 #include "core/World.h"
 
+Entity::Entity()
+{
+    getHandleTable<Entity>().acquire(this, handle.index, handle.generation);
+    typeStarts.push_back(0);
+}
+
+Entity::~Entity()
+{
+    getHandleTable<Entity>().release(handle.index);
+}
+
 Query<shared_ptr<Component>> Entity::queryComponents()
 {
-    return Query<shared_ptr<Component>>(components);
+    return Query<shared_ptr<Component>>(hash_set<shared_ptr<Component>>(components.begin(), components.end()));
 }
 
 void Entity::addComponent(shared_ptr<Component> component)
 {
-    components.insert(component);
-    component->owner = shared_from_this();
+    if(findComponentIndex(component.get()) != (size_t)-1) {
+        return;
+    }
+    insertComponent(component);
+    component->owner = handle;
     shared_ptr<World> worldPtr = world.lock();
     if(worldPtr) {
         worldPtr->addComponent(component);
@@ -23,65 +37,106 @@ void Entity::removeComponent(shared_ptr<Component> component)
     if(!component) {
         return;
     }
-    auto it = components.find(component);
-    if(it != components.end()) {
-        components.erase(it);
-    }
+    size_t index = findComponentIndex(component.get());
+    // Tell the world first, so its views still see the component attached to its owner.
     shared_ptr<World> worldPtr = world.lock();
     if(worldPtr) {
         worldPtr->removeComponent(component);
     }
+    if(index != (size_t)-1) {
+        eraseComponent(index);
+    }
 }
 
 shared_ptr<Component> Entity::removeComponentByType(uint typeId)
 {
+    if(!hasComponentOfType(typeId)) {
+        return nullptr;
+    }
+    size_t index = typeStarts[getTypeRank(typeId)];
+    shared_ptr<Component> out = components[index];
     shared_ptr<World> worldPtr = world.lock();
-    for(auto it = components.begin(); it != components.end(); ++it) {
-        if((*it)->getTypeId() == typeId) {
-            shared_ptr<Component> out = *it;
-            components.erase(it);
-            if(worldPtr) {
-                worldPtr->removeComponent(out);
-            }
-            return out;
-        }
+    if(worldPtr) {
+        worldPtr->removeComponent(out);
     }
-    return nullptr;
+    eraseComponent(index);
+    return out;
 }
 
 void Entity::removeComponentsByType(uint typeId)
 {
+    if(!hasComponentOfType(typeId)) {
+        return;
+    }
+    uint rank = getTypeRank(typeId);
+    vector<shared_ptr<Component>> removed(components.begin() + typeStarts[rank], components.begin() + typeStarts[rank + 1]);
     shared_ptr<World> worldPtr = world.lock();
-    hash_set<shared_ptr<Component>> newComponents;
-    for(auto it = components.begin(); it != components.end(); ++it) {
-        if((*it)->getTypeId() != typeId) {
-            newComponents.insert(*it);
-        } else {
-            if(worldPtr) {
-                worldPtr->removeComponent(*it);
-            }
+    // One at a time, so the world sees each component attached and the ones before it already gone.
+    for(size_t i = removed.size(); i > 0; i--) {
+        if(worldPtr) {
+            worldPtr->removeComponent(removed[i - 1]);
         }
+        eraseComponent(typeStarts[rank] + i - 1);
     }
-    components = newComponents;
 }
 
 shared_ptr<Component> Entity::findComponentByType(uint typeId)
 {
-    for(shared_ptr<Component> component : components) {
-        if(component->getTypeId() == typeId) {
-            return component;
-        }
+    return hasComponentOfType(typeId) ? components[typeStarts[getTypeRank(typeId)]] : nullptr;
+}
+
+size_t Entity::countComponentsOfType(uint typeId) const
+{
+    if(!hasComponentOfType(typeId)) {
+        return 0;
     }
-    return nullptr;
+    uint rank = getTypeRank(typeId);
+    return typeStarts[rank + 1] - typeStarts[rank];
 }
 
-hash_set<shared_ptr<Component>> Entity::findComponentsByType(uint typeId)
+void Entity::insertComponent(shared_ptr<Component> component)
 {
-    hash_set<shared_ptr<Component>> typedComponents;
-    for(shared_ptr<Component> component : components) {
-        if(component->getTypeId() == typeId) {
-            typedComponents.insert(component);
+    uint typeId = component->getTypeId();
+    uint rank = getTypeRank(typeId);
+    bool present = hasComponentOfType(typeId);
+    // New components go after any others of the same type.
+    size_t index = present ? typeStarts[rank + 1] : typeStarts[rank];
+    components.insert(components.begin() + index, move(component));
+    if(!present) {
+        typeStarts.insert(typeStarts.begin() + rank, (ushort)index);
+        componentMask.set(typeId);
+    }
+    for(size_t i = rank + 1; i < typeStarts.size(); i++) {
+        typeStarts[i]++;
+    }
+}
+
+void Entity::eraseComponent(size_t index)
+{
+    uint typeId = components[index]->getTypeId();
+    uint rank = getTypeRank(typeId);
+    components.erase(components.begin() + index);
+    for(size_t i = rank + 1; i < typeStarts.size(); i++) {
+        typeStarts[i]--;
+    }
+    // Drop the type once its last component is gone.
+    if(typeStarts[rank] == typeStarts[rank + 1]) {
+        typeStarts.erase(typeStarts.begin() + rank);
+        componentMask.reset(typeId);
+    }
+}
+
+size_t Entity::findComponentIndex(const Component* component) const
+{
+    uint typeId = component->getTypeId();
+    if(!hasComponentOfType(typeId)) {
+        return (size_t)-1;
+    }
+    uint rank = getTypeRank(typeId);
+    for(size_t i = typeStarts[rank]; i < typeStarts[rank + 1]; i++) {
+        if(components[i].get() == component) {
+            return i;
         }
     }
-    return typedComponents;
+    return (size_t)-1;
 }
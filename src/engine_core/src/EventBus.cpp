@@ -0,0 +1,47 @@
+#include "core/EventBus.h"
+
+uint registerEventType()
+{
+    static atomic<uint> count(0);
+    uint index = count.fetch_add(1);
+    if(index >= MAX_EVENT_TYPES) {
+        throw "Too many event types. Increase MAX_EVENT_TYPES.";
+    }
+    return index;
+}
+
+EventBus::EventBus()
+{
+    for(uint i = 0; i < MAX_EVENT_TYPES; i++) {
+        channels[i].store(nullptr, memory_order_relaxed);
+    }
+}
+
+EventBus::~EventBus()
+{
+    for(uint i = 0; i < MAX_EVENT_TYPES; i++) {
+        delete channels[i].load(memory_order_relaxed);
+    }
+}
+
+void EventBus::swap()
+{
+    for(uint i = 0; i < MAX_EVENT_TYPES; i++) {
+        EventChannelBase* channel = channels[i].load(memory_order_acquire);
+        if(channel) {
+            channel->swap();
+        }
+    }
+}
+
+EventChannelBase* EventBus::addChannel(uint index, EventChannelBase* channel)
+{
+    lock_guard<mutex> guard(lock);
+    EventChannelBase* existing = channels[index].load(memory_order_relaxed);
+    if(existing) {
+        delete channel;
+        return existing;
+    }
+    channels[index].store(channel, memory_order_release);
+    return channel;
+}
@@ -0,0 +1,74 @@
+#include "core/Handle.h"
+
+HandleTable::HandleTable() : slotCount(0), freeHead(NO_SLOT)
+{
+    for(uint i = 0; i < MAX_PAGES; i++) {
+        pages[i].store(nullptr, memory_order_relaxed);
+    }
+}
+
+HandleTable::~HandleTable()
+{
+    for(uint i = 0; i < MAX_PAGES; i++) {
+        delete[] pages[i].load(memory_order_relaxed);
+    }
+}
+
+void HandleTable::acquire(void* object, uint& index, uint& generation)
+{
+    // Pop a free slot. A stale head fails the swap even if its slot is back on top, since the tag has moved on.
+    uint64_t head = freeHead.load(memory_order_acquire);
+    index = NO_SLOT;
+    while((uint)head != NO_SLOT) {
+        uint next = getSlot((uint)head).nextFree.load(memory_order_relaxed);
+        uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+        if(freeHead.compare_exchange_weak(head, newHead, memory_order_acquire, memory_order_acquire)) {
+            index = (uint)head;
+            break;
+        }
+    }
+    if(index == NO_SLOT) {
+        index = slotCount.fetch_add(1, memory_order_relaxed);
+        if(index >= MAX_PAGES * PAGE_SIZE) {
+            throw "Too many live handles. Increase HandleTable::MAX_PAGES.";
+        }
+        // Whoever hands out a page's first slot allocates the page, but other threads may need it sooner.
+        atomic<Slot*>& pageSlot = pages[index >> PAGE_BITS];
+        if(!pageSlot.load(memory_order_acquire)) {
+            Slot* page = new Slot[PAGE_SIZE];
+            for(uint i = 0; i < PAGE_SIZE; i++) {
+                page[i].object.store(nullptr, memory_order_relaxed);
+                page[i].generation.store(0, memory_order_relaxed);
+                page[i].nextFree.store(NO_SLOT, memory_order_relaxed);
+            }
+            Slot* expected = nullptr;
+            if(!pageSlot.compare_exchange_strong(expected, page, memory_order_acq_rel)) {
+                delete[] page;
+            }
+        }
+    }
+    Slot& slot = getSlot(index);
+    // Skip generation 0 so that default constructed handles never resolve.
+    generation = slot.generation.load(memory_order_relaxed) + 1;
+    if(generation == 0) {
+        generation++;
+    }
+    // Publish the object before the generation, so a matching generation always sees it.
+    slot.object.store(object, memory_order_release);
+    slot.generation.store(generation, memory_order_release);
+}
+
+void HandleTable::release(uint index)
+{
+    Slot& slot = getSlot(index);
+    // Invalidate the handles before clearing the object. See resolve.
+    slot.generation.store(slot.generation.load(memory_order_relaxed) + 1, memory_order_release);
+    slot.object.store(nullptr, memory_order_release);
+
+    uint64_t head = freeHead.load(memory_order_relaxed);
+    uint64_t newHead;
+    do {
+        slot.nextFree.store((uint)head, memory_order_relaxed);
+        newHead = (((head >> 32) + 1) << 32) | index;
+    } while(!freeHead.compare_exchange_weak(head, newHead, memory_order_release, memory_order_relaxed));
+}
@@ -0,0 +1,141 @@
+
+#include "core/JobSystem.h"
+
+// The pool that the current thread is a worker of, and its index in that pool.
+static thread_local const JobSystem* currentPool = nullptr;
+static thread_local uint currentWorker = 0;
+
+JobSystem::JobSystem(uint workerCount)
+    : queues(new WorkQueue[workerCount > 0 ? workerCount : 1]),
+    queuedJobs(0), sleepingWorkers(0), stopping(false)
+{
+    workers.reserve(workerCount);
+    for(uint i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping.store(true);
+    }
+    jobAvailable.notify_all();
+    for(thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::submit(function<void()> job, JobCounter* counter)
+{
+    if(counter) {
+        counter->pending.fetch_add(1, memory_order_relaxed);
+    }
+    // Count the job before it becomes visible, so takers never see the count go below zero.
+    queuedJobs.fetch_add(1);
+    WorkQueue& queue = currentPool == this ? queues[currentWorker] : sharedQueue;
+    {
+        lock_guard<mutex> guard(queue.lock);
+        queue.jobs.push_back({ move(job), counter });
+    }
+    if(sleepingWorkers.load() > 0) {
+        lock_guard<mutex> guard(sleepLock);
+        jobAvailable.notify_one();
+    }
+}
+
+bool JobSystem::tryRunJob()
+{
+    Job job;
+    if(!takeJob(job)) {
+        return false;
+    }
+    runJob(job);
+    return true;
+}
+
+void JobSystem::wait(const JobCounter& counter)
+{
+    while(!counter.isDone()) {
+        if(!tryRunJob()) {
+            this_thread::yield();
+        }
+    }
+}
+
+uint JobSystem::getDefaultWorkerCount()
+{
+    uint hardwareThreads = thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+bool JobSystem::takeJob(Job& job)
+{
+    if(queuedJobs.load(memory_order_relaxed) == 0) {
+        return false;
+    }
+    bool isWorker = currentPool == this;
+    // Our own queue is used as a stack, so the most recently split work stays in cache.
+    if(isWorker) {
+        WorkQueue& own = queues[currentWorker];
+        lock_guard<mutex> guard(own.lock);
+        if(!own.jobs.empty()) {
+            job = move(own.jobs.back());
+            own.jobs.pop_back();
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    {
+        lock_guard<mutex> guard(sharedQueue.lock);
+        if(!sharedQueue.jobs.empty()) {
+            job = move(sharedQueue.jobs.front());
+            sharedQueue.jobs.pop_front();
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    // Steal the oldest job of another worker, starting after our own queue to spread thieves out.
+    uint workerCount = getWorkerCount();
+    uint start = isWorker ? currentWorker + 1 : 0;
+    for(uint i = 0; i < workerCount; i++) {
+        WorkQueue& victim = queues[(start + i) % workerCount];
+        lock_guard<mutex> guard(victim.lock);
+        if(!victim.jobs.empty()) {
+            job = move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::runJob(Job& job)
+{
+    job.fcn();
+    if(job.counter) {
+        job.counter->pending.fetch_sub(1, memory_order_release);
+    }
+}
+
+void JobSystem::workerLoop(uint index)
+{
+    currentPool = this;
+    currentWorker = index;
+    while(true) {
+        Job job;
+        if(takeJob(job)) {
+            runJob(job);
+            continue;
+        }
+        unique_lock<mutex> guard(sleepLock);
+        sleepingWorkers.fetch_add(1);
+        jobAvailable.wait(guard, [this]() { return stopping.load() || queuedJobs.load() > 0; });
+        sleepingWorkers.fetch_sub(1);
+        if(stopping.load() && queuedJobs.load() == 0) {
+            return;
+        }
+    }
+}
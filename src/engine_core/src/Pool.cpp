@@ -0,0 +1,143 @@
+
+#include "core/Pool.h"
+
+#include <cstdlib>
+
+// Allocates memory aligned to the alignment, which must be a power of two.
+static void* allocateAligned(size_t size, size_t alignment)
+{
+#ifdef _MSC_VER
+    return _aligned_malloc(size, alignment);
+#else
+    void* memory = nullptr;
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+#endif
+}
+
+static void freeAligned(void* memory)
+{
+#ifdef _MSC_VER
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+Pool::Pool(const string& _name, size_t _blockSize, size_t blockAlignment)
+    : name(_name)
+{
+    // Blocks must hold a free list link and keep every block in a slab aligned.
+    size_t alignment = blockAlignment > alignof(FreeBlock) ? blockAlignment : alignof(FreeBlock);
+    blockSize = _blockSize > sizeof(FreeBlock) ? _blockSize : sizeof(FreeBlock);
+    blockSize = (blockSize + alignment - 1) / alignment * alignment;
+    blocksPerSlab = SLAB_BYTES / blockSize > 0 ? SLAB_BYTES / blockSize : 1;
+    slabAlignment = alignment > POOL_SLAB_ALIGNMENT ? alignment : POOL_SLAB_ALIGNMENT;
+}
+
+Pool::~Pool()
+{
+    for(void* slab : slabs) {
+        freeAligned(slab);
+    }
+}
+
+void* Pool::allocate()
+{
+    lock_guard<SpinLock> guard(lock);
+    if(!freeList) {
+        addSlab();
+    }
+    FreeBlock* block = freeList;
+    freeList = block->next;
+    liveCount++;
+    return block;
+}
+
+void Pool::deallocate(void* block)
+{
+    lock_guard<SpinLock> guard(lock);
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = freeList;
+    freeList = freeBlock;
+    liveCount--;
+}
+
+PoolStats Pool::getStats() const
+{
+    lock_guard<SpinLock> guard(lock);
+    PoolStats stats;
+    stats.name = name;
+    stats.blockSize = blockSize;
+    stats.liveCount = liveCount;
+    stats.slabCount = slabs.size();
+    stats.capacity = slabs.size() * blocksPerSlab;
+    return stats;
+}
+
+void Pool::addSlab()
+{
+    char* slab = static_cast<char*>(allocateAligned(blocksPerSlab * blockSize, slabAlignment));
+    if(!slab) {
+        throw bad_alloc();
+    }
+    slabs.push_back(slab);
+    // Thread the new blocks onto the free list in address order, so consecutive allocations are adjacent.
+    for(size_t i = blocksPerSlab; i > 0; i--) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * blockSize);
+        block->next = freeList;
+        freeList = block;
+    }
+}
+
+uint registerPoolType()
+{
+    static atomic<uint> count(0);
+    uint index = count.fetch_add(1);
+    if(index >= MAX_POOL_TYPES) {
+        throw "Too many pooled types. Increase MAX_POOL_TYPES.";
+    }
+    return index;
+}
+
+shared_ptr<PoolSet> PoolSet::create()
+{
+    return shared_ptr<PoolSet>(new PoolSet(), [](PoolSet* pools) { pools->release(); });
+}
+
+PoolSet::PoolSet()
+    : references(1)
+{
+    for(uint i = 0; i < MAX_POOL_TYPES; i++) {
+        pools[i].store(nullptr, memory_order_relaxed);
+    }
+}
+
+PoolSet::~PoolSet()
+{
+    for(uint i = 0; i < MAX_POOL_TYPES; i++) {
+        delete pools[i].load(memory_order_relaxed);
+    }
+}
+
+Pool& PoolSet::createPool(uint typeIndex, const char* signature, size_t blockSize, size_t blockAlignment)
+{
+    lock_guard<mutex> guard(lock);
+    Pool* pool = pools[typeIndex].load(memory_order_relaxed);
+    if(!pool) {
+        pool = new Pool(extractTypeName(signature), blockSize, blockAlignment);
+        pools[typeIndex].store(pool, memory_order_release);
+    }
+    return *pool;
+}
+
+vector<PoolStats> PoolSet::getStats() const
+{
+    vector<PoolStats> stats;
+    for(uint i = 0; i < MAX_POOL_TYPES; i++) {
+        Pool* pool = pools[i].load(memory_order_acquire);
+        if(pool) {
+            stats.push_back(pool->getStats());
+        }
+    }
+    return stats;
+}
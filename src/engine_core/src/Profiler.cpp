@@ -0,0 +1,215 @@
+#include "core/Profiler.h"
+
+#ifdef ENGINE_PROFILING
+
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+// Holds the buffer of the calling thread, taken on its first sample, and hands it back when the thread exits.
+struct ThreadBufferOwner
+{
+    Profiler::ThreadBuffer* buffer = nullptr;
+
+    ~ThreadBufferOwner() {
+        if(buffer) {
+            Profiler::get().releaseThreadBuffer(buffer);
+        }
+    }
+};
+static thread_local ThreadBufferOwner currentBuffer;
+
+Profiler& Profiler::get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+const char* Profiler::intern(const string& name)
+{
+    lock_guard<mutex> guard(lock);
+    return names.insert(name).first->c_str();
+}
+
+const char* Profiler::internTypeName(const type_info& type)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = typeNames.find(type_index(type));
+        if(it != typeNames.end()) {
+            return it->second;
+        }
+    }
+    string name = type.name();
+#ifdef __GNUG__
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if(demangled) {
+        name = demangled;
+        free(demangled);
+    }
+#else
+    // MSVC names are readable, but prefixed with "class " or "struct ".
+    for(const char* prefix : { "class ", "struct " }) {
+        if(name.compare(0, strlen(prefix), prefix) == 0) {
+            name = name.substr(strlen(prefix));
+        }
+    }
+#endif
+    const char* interned = intern(name);
+    lock_guard<mutex> guard(lock);
+    typeNames[type_index(type)] = interned;
+    return interned;
+}
+
+uint64_t Profiler::now()
+{
+    static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+Profiler::ThreadBuffer* Profiler::getThreadBuffer()
+{
+    if(!currentBuffer.buffer) {
+        lock_guard<mutex> guard(lock);
+        // Reusing buffers keeps their number at the most threads that were ever alive at once.
+        if(!freeBuffers.empty()) {
+            currentBuffer.buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+        } else {
+            buffers.emplace_back(new ThreadBuffer());
+            buffers.back()->thread = (uint)(buffers.size() - 1);
+            currentBuffer.buffer = buffers.back().get();
+        }
+    }
+    return currentBuffer.buffer;
+}
+
+void Profiler::releaseThreadBuffer(ThreadBuffer* buffer)
+{
+    lock_guard<mutex> guard(lock);
+    freeBuffers.push_back(buffer);
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    uint64_t head = buffer->head.load(memory_order_relaxed);
+    buffer->events[head % THREAD_BUFFER_SIZE] = { name, start, end, buffer->thread };
+    buffer->head.store(head + 1, memory_order_release);
+}
+
+void Profiler::collect()
+{
+    lock_guard<mutex> guard(lock);
+    vector<ProfileEvent> collected;
+    for(const unique_ptr<ThreadBuffer>& buffer : buffers) {
+        uint64_t head = buffer->head.load(memory_order_acquire);
+        // Anything more than a buffer behind has already been overwritten.
+        uint64_t first = head - buffer->tail > THREAD_BUFFER_SIZE ? head - THREAD_BUFFER_SIZE : buffer->tail;
+        size_t start = collected.size();
+        for(uint64_t i = first; i < head; i++) {
+            collected.push_back(buffer->events[i % THREAD_BUFFER_SIZE]);
+        }
+        // The thread kept recording while we copied. Drop the copies it may have overwritten.
+        uint64_t newHead = buffer->head.load(memory_order_acquire);
+        if(newHead - first > THREAD_BUFFER_SIZE) {
+            size_t overwritten = (size_t)min<uint64_t>(newHead - first - THREAD_BUFFER_SIZE, head - first);
+            collected.erase(collected.begin() + start, collected.begin() + start + overwritten);
+        }
+        buffer->tail = head;
+    }
+
+    for(const ProfileEvent& event : collected) {
+        if(trace.size() < MAX_TRACE_EVENTS) {
+            trace.push_back(event);
+        } else {
+            trace[traceNext] = event;
+            traceNext = (traceNext + 1) % MAX_TRACE_EVENTS;
+        }
+        RollingSamples& rolling = samples[event.name];
+        double duration = (event.end - event.start) / 1e6;
+        if(rolling.durations.size() < SUMMARY_WINDOW) {
+            rolling.durations.push_back(duration);
+        } else {
+            rolling.durations[rolling.next] = duration;
+            rolling.next = (rolling.next + 1) % SUMMARY_WINDOW;
+        }
+    }
+}
+
+// Writes the string as a JSON string literal.
+static void writeJsonString(ostream& out, const char* str)
+{
+    out << '"';
+    for(; *str; str++) {
+        char c = *str;
+        if(c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if((uchar)c < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+bool Profiler::writeChromeTrace(const string& path)
+{
+    ofstream out(path);
+    if(!out) {
+        return false;
+    }
+    lock_guard<mutex> guard(lock);
+    out << fixed << setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    // Once the trace has wrapped, the oldest event is the next one to be replaced.
+    for(size_t i = 0; i < trace.size(); i++) {
+        const ProfileEvent& event = trace[(traceNext + i) % trace.size()];
+        out << (i == 0 ? "" : ",\n") << "{\"name\":";
+        writeJsonString(out, event.name);
+        // Chrome expects microseconds.
+        out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+            << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
+
+vector<ProfileSummary> Profiler::getSummary()
+{
+    lock_guard<mutex> guard(lock);
+    vector<ProfileSummary> summary;
+    summary.reserve(samples.size());
+    for(auto& entry : samples) {
+        vector<double> durations = entry.second.durations;
+        if(durations.empty()) {
+            continue;
+        }
+        sort(durations.begin(), durations.end());
+        double total = 0;
+        for(double duration : durations) {
+            total += duration;
+        }
+        size_t p99 = (durations.size() * 99 + 99) / 100 - 1;
+        summary.push_back({ entry.first, durations.size(), durations.front(), total / durations.size(),
+            durations[p99 < durations.size() ? p99 : durations.size() - 1] });
+    }
+    return summary;
+}
+
+void Profiler::clear()
+{
+    lock_guard<mutex> guard(lock);
+    trace.clear();
+    traceNext = 0;
+    samples.clear();
+}
+
+#endif
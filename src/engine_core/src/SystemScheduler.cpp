@@ -0,0 +1,119 @@
+
+#include "core/SystemScheduler.h"
+#include "core/System.h"
+#include "core/JobSystem.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+// Does any type in a appear in b.
+static bool intersects(const vector<uint>& a, const vector<uint>& b)
+{
+    for(uint type : a) {
+        if(find(b.begin(), b.end(), type) != b.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SystemScheduler::conflicts(const System& a, const System& b)
+{
+    if(a.isExclusive() || b.isExclusive()) {
+        return true;
+    }
+    if(a.mainThreadOnly && b.mainThreadOnly) {
+        return true;
+    }
+    return intersects(a.getWriteTypes(), b.getWriteTypes())
+        || intersects(a.getWriteTypes(), b.getReadTypes())
+        || intersects(b.getWriteTypes(), a.getReadTypes());
+}
+
+void SystemScheduler::build(const vector<shared_ptr<System>>& systems)
+{
+    nodes.clear();
+    nodes.resize(systems.size());
+    for(uint i = 0; i < systems.size(); i++) {
+        for(uint j = 0; j < i; j++) {
+            if(conflicts(*systems[j], *systems[i])) {
+                nodes[j].dependents.push_back(i);
+                nodes[i].dependencyCount++;
+            }
+        }
+    }
+    dirty = false;
+}
+
+void SystemScheduler::run(const vector<shared_ptr<System>>& systems, JobSystem* jobs,
+    const function<void(System&)>& fcn)
+{
+    if(!jobs || systems.size() <= 1) {
+        for(const shared_ptr<System>& system : systems) {
+            fcn(*system);
+        }
+        return;
+    }
+    if(dirty || nodes.size() != systems.size()) {
+        build(systems);
+    }
+
+    mutex lock; // Guards everything below.
+    condition_variable changed; // Signalled when a system finishes or a main thread system becomes ready.
+    vector<uint> waitingOn(nodes.size());
+    deque<uint> mainThreadReady; // Main thread systems whose dependencies have finished.
+    size_t remaining = systems.size();
+
+    function<void(uint)> dispatch;
+    // Must be called while holding lock.
+    auto finish = [&](uint index) {
+        remaining--;
+        for(uint dependent : nodes[index].dependents) {
+            if(--waitingOn[dependent] == 0) {
+                dispatch(dependent);
+            }
+        }
+        changed.notify_all();
+    };
+    // Must be called while holding lock.
+    dispatch = [&](uint index) {
+        if(systems[index]->mainThreadOnly) {
+            mainThreadReady.push_back(index);
+            return;
+        }
+        jobs->submit([&, index]() {
+            fcn(*systems[index]);
+            lock_guard<mutex> guard(lock);
+            finish(index);
+        });
+    };
+
+    unique_lock<mutex> guard(lock);
+    for(uint i = 0; i < nodes.size(); i++) {
+        waitingOn[i] = nodes[i].dependencyCount;
+    }
+    for(uint i = 0; i < nodes.size(); i++) {
+        if(waitingOn[i] == 0) {
+            dispatch(i);
+        }
+    }
+    while(remaining > 0) {
+        if(!mainThreadReady.empty()) {
+            uint index = mainThreadReady.front();
+            mainThreadReady.pop_front();
+            guard.unlock();
+            fcn(*systems[index]);
+            guard.lock();
+            finish(index);
+            continue;
+        }
+        // Help the workers rather than sleeping, so a pool without workers still finishes.
+        guard.unlock();
+        bool ranJob = jobs->tryRunJob();
+        guard.lock();
+        if(!ranJob && remaining > 0 && mainThreadReady.empty()) {
+            changed.wait(guard);
+        }
+    }
+}
@@ -0,0 +1,249 @@
+#include "core/Task.h"
+
+#include <cmath>
+
+// Frames are rounded up to one of these sizes. Larger frames go to the heap.
+static const size_t FRAME_SIZE_CLASSES[] = { 128, 256, 512, 1024, 2048 };
+static const size_t FRAME_SIZE_CLASS_COUNT = sizeof(FRAME_SIZE_CLASSES) / sizeof(size_t);
+
+// The block type of each size class, so each class gets its own pool in a PoolSet.
+template<size_t Size>
+struct TaskFrameBlock
+{
+    alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) char bytes[Size];
+};
+
+template<size_t Size>
+static Pool& getFramePool(PoolSet& pools)
+{
+    typedef TaskFrameBlock<Size> Block;
+    return pools.getPool(getPoolTypeIndex<Block>(), getTypeSignature<Block>(), sizeof(Block), alignof(Block));
+}
+
+static Pool& (*const FRAME_POOLS[])(PoolSet&) = {
+    &getFramePool<128>, &getFramePool<256>, &getFramePool<512>, &getFramePool<1024>, &getFramePool<2048>
+};
+static_assert(sizeof(FRAME_POOLS) / sizeof(FRAME_POOLS[0]) == FRAME_SIZE_CLASS_COUNT, "One pool per size class.");
+
+// Precedes every pooled frame, so the frame goes back to the pool it came from.
+struct FrameHeader
+{
+    PoolSet* pools;
+    Pool* pool;
+};
+static const size_t FRAME_HEADER_SIZE = (sizeof(FrameHeader) + __STDCPP_DEFAULT_NEW_ALIGNMENT__ - 1)
+    / __STDCPP_DEFAULT_NEW_ALIGNMENT__ * __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+static size_t getFrameSizeClass(size_t size)
+{
+    size_t index = 0;
+    while(index < FRAME_SIZE_CLASS_COUNT && FRAME_SIZE_CLASSES[index] < size + FRAME_HEADER_SIZE) {
+        index++;
+    }
+    return index;
+}
+
+// The pools frames created on this thread are drawn from. See TaskFramePoolScope.
+static thread_local PoolSet* currentFramePools = nullptr;
+
+// The pools of frames created outside any world's tick. Frames keep the set alive, even past static destruction.
+static PoolSet& getSharedFramePools()
+{
+    static shared_ptr<PoolSet> pools = PoolSet::create();
+    return *pools;
+}
+
+TaskFramePoolScope::TaskFramePoolScope(PoolSet* pools)
+    : previous(currentFramePools)
+{
+    currentFramePools = pools;
+}
+
+TaskFramePoolScope::~TaskFramePoolScope()
+{
+    currentFramePools = previous;
+}
+
+Task& Task::operator=(Task&& other) noexcept
+{
+    if(this != &other) {
+        if(handle) {
+            handle.destroy();
+        }
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+Task::~Task()
+{
+    if(handle) {
+        handle.destroy();
+    }
+}
+
+TaskPromise::~TaskPromise()
+{
+    if(scheduler) {
+        scheduler->unlink(*this);
+    }
+}
+
+coroutine_handle<> TaskPromise::FinalAwaiter::await_suspend(coroutine_handle<TaskPromise> handle) noexcept
+{
+    TaskJoin* join = handle.promise().join;
+    handle.destroy();
+    if(join && --join->remaining == 0) {
+        return join->parent;
+    }
+    return noop_coroutine();
+}
+
+void* TaskPromise::operator new(size_t size)
+{
+    size_t sizeClass = getFrameSizeClass(size);
+    if(sizeClass == FRAME_SIZE_CLASS_COUNT) {
+        return ::operator new(size);
+    }
+    PoolSet& pools = currentFramePools ? *currentFramePools : getSharedFramePools();
+    Pool& pool = FRAME_POOLS[sizeClass](pools);
+    char* block = static_cast<char*>(pool.allocate());
+    pools.retain();
+    new(block) FrameHeader{ &pools, &pool };
+    return block + FRAME_HEADER_SIZE;
+}
+
+void TaskPromise::operator delete(void* frame, size_t size)
+{
+    if(getFrameSizeClass(size) == FRAME_SIZE_CLASS_COUNT) {
+        ::operator delete(frame);
+        return;
+    }
+    char* block = static_cast<char*>(frame) - FRAME_HEADER_SIZE;
+    FrameHeader header = *reinterpret_cast<FrameHeader*>(block);
+    header.pool->deallocate(block);
+    // May free the pool, so release last.
+    header.pools->release();
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    // Destroying a frame only runs the destructors of its locals, which never resume or start other tasks.
+    while(live) {
+        live->getHandle().destroy();
+    }
+    for(coroutine_handle<TaskPromise> handle : started) {
+        handle.destroy();
+    }
+}
+
+void TaskScheduler::start(Task task)
+{
+    coroutine_handle<TaskPromise> handle = task.release();
+    if(!handle) {
+        return;
+    }
+    lock_guard<SpinLock> guard(startLock);
+    started.push_back(handle);
+}
+
+void TaskScheduler::update(float delta)
+{
+    tick++;
+    tickDelta = delta;
+
+    vector<coroutine_handle<TaskPromise>> starting;
+    {
+        lock_guard<SpinLock> guard(startLock);
+        swap(starting, started);
+    }
+    for(coroutine_handle<TaskPromise> handle : starting) {
+        run(handle);
+    }
+
+    // Tasks that wait again go into fresh queues, so nothing resumes twice in one update.
+    size_t slot = tick % WHEEL_SIZE;
+    TaskQueue due = wheel[slot].take();
+    while(TaskPromise* task = due.pop()) {
+        if(task->wakeTick <= tick) {
+            task->getHandle().resume();
+        } else {
+            wheel[slot].push(task);
+        }
+    }
+
+    TaskQueue waiting = polling.take();
+    while(TaskPromise* task = waiting.pop()) {
+        if(task->poll(task->pollContext)) {
+            task->poll = nullptr;
+            task->pollContext = nullptr;
+            task->getHandle().resume();
+        } else {
+            polling.push(task);
+        }
+    }
+}
+
+void TaskScheduler::run(coroutine_handle<TaskPromise> handle)
+{
+    TaskPromise& task = handle.promise();
+    task.scheduler = this;
+    task.previousLive = nullptr;
+    task.nextLive = live;
+    if(live) {
+        live->previousLive = &task;
+    }
+    live = &task;
+    liveCount++;
+    handle.resume();
+}
+
+void TaskScheduler::waitTicks(TaskPromise& task, uint64_t ticks)
+{
+    task.wakeTick = tick + (ticks > 0 ? ticks : 1);
+    wheel[task.wakeTick % WHEEL_SIZE].push(&task);
+}
+
+void TaskScheduler::waitUntil(TaskPromise& task, bool (*poll)(void*), void* context)
+{
+    task.poll = poll;
+    task.pollContext = context;
+    polling.push(&task);
+}
+
+void TaskScheduler::unlink(TaskPromise& task)
+{
+    (task.previousLive ? task.previousLive->nextLive : live) = task.nextLive;
+    if(task.nextLive) {
+        task.nextLive->previousLive = task.previousLive;
+    }
+    liveCount--;
+}
+
+void SecondsAwaiter::await_suspend(coroutine_handle<TaskPromise> handle)
+{
+    TaskScheduler& scheduler = *handle.promise().scheduler;
+    // Allow for rounding error, so a duration of exactly n ticks does not wait n + 1.
+    float ticks = ceil(duration / scheduler.getTickDelta() - 1e-4f);
+    scheduler.waitTicks(handle.promise(), ticks > 1 ? (uint64_t)ticks : 1);
+}
+
+bool AllOfAwaiter::await_suspend(coroutine_handle<TaskPromise> handle)
+{
+    TaskScheduler& scheduler = *handle.promise().scheduler;
+    // Hold one count back until every child has started, so children that return immediately cannot resume the
+    // parent while it is still starting the rest.
+    join.remaining = tasks.size() + 1;
+    join.parent = handle;
+    for(Task& task : tasks) {
+        coroutine_handle<TaskPromise> child = task.release();
+        if(child) {
+            child.promise().join = &join;
+            scheduler.run(child);
+        } else {
+            join.remaining--;
+        }
+    }
+    return --join.remaining > 0;
+}
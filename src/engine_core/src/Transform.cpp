@@ -4,26 +4,29 @@
 #include "core/Universe.h"
 
 #include <sstream>
+#include <cassert>
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtx/transform.hpp>
 
 Transform::~Transform()
 {
-    shared_ptr<Transform> parentPtr = parent.lock();
-    if(parentPtr) {
-        // Erase one null pointer since that will correspond to us.
-        auto it = find_if(parentPtr->children.begin(), parentPtr->children.end(),
-            [](const weak_ptr<Transform>& child){
-                return child.lock() == nullptr;
-            });
-        assert(it != parentPtr->children.end());
-        parentPtr->children.erase(it);
+    detach();
+    // The children are attached to the world from now on, so their cached global transforms are stale.
+    Transform* child = firstChild.get();
+    while(child) {
+        Transform* next = child->nextSibling.get();
+        child->parent = nullptr;
+        child->prevSibling = nullptr;
+        child->nextSibling = nullptr;
+        child->depth = 0;
+        child->markLocalChanged();
+        child = next;
     }
 }
 
-void Transform::setParent(shared_ptr<Transform> newParent, bool keepGlobal)
+void Transform::setParent(Transform* newParent, bool keepGlobal)
 {
-    shared_ptr<Transform> parentPtr = parent.lock();
+    Transform* parentPtr = parent.get();
     if(parentPtr == newParent) {
         return;
     }
@@ -31,51 +34,79 @@ void Transform::setParent(shared_ptr<Transform> newParent, bool keepGlobal)
     TransformData transform = getRelativeTransform();
     if(keepGlobal) { transform = getGlobalTransform(); }
 
-    shared_ptr<Transform> sharedThis = static_pointer_cast<Transform>(shared_from_this());
-
-    if(parentPtr) {
-        parent = weak_ptr<Transform>();
-
-        auto it = find_if(parentPtr->children.begin(), parentPtr->children.end(),
-            [&sharedThis](const weak_ptr<Transform>& child){
-                return sharedThis == child.lock();
-            });
-        assert(it != parentPtr->children.end());
-        parentPtr->children.erase(it);
+    /*
+    The new parent can only be a descendant (which would create a cycle) if it is deeper than this transform. Only
+    then climb to this transform's depth and see if we land on it. This must happen before detaching, which resets
+    the depth.
+    */
+    bool createsCycle = false;
+    if(newParent && newParent->depth > depth) {
+        Transform* curr = newParent;
+        for(uint i = newParent->depth; i > depth && curr; i--) {
+            curr = curr->parent.get();
+        }
+        createsCycle = curr == this;
+    } else {
+        createsCycle = newParent == this;
     }
 
-    // We put this a little higher because otherwise the compiler complains about the goto.
-    shared_ptr<Transform> curr = newParent;
-    // We already handled this when parent was valid.
-    if(!newParent) {
-        goto end; // goto here is convenient because we also need to goto in the case of a cycle.
-    }
+    detach();
 
-    while(curr) {
-        if(curr.get() == this) {
-            // If the ancestor is equal to this, the ancestry creates a cycle - invalid (attaches to world).
-            goto end;
-        }
-        // Climb to the next ancestor.
-        curr = curr->parent.lock();
+    // If the ancestry creates a cycle it is invalid, so we stay attached to the world.
+    if(newParent && !createsCycle) {
+        attach(newParent);
     }
 
-    // If we reach here, that means the parent is valid, so:
-    parent = newParent;
-    // Tell the parent we are a child.
-    newParent->children.push_back(sharedThis);
-end:
-    // Setting global transform changes the update id.
+    // Setting global transform changes the version (and refreshes the depths).
     if(keepGlobal) {
         setGlobalTransform(transform);
-    } else { // If we don't set the global transform, just increment.
-        incrementUpdateId();
+    } else { // If we don't set the global transform, just mark the change.
+        markLocalChanged();
     }
 }
 
-shared_ptr<Transform> Transform::getParent() const
+void Transform::attach(Transform* newParent)
 {
-    return parent.lock();
+    assert(!parent.get());
+    Handle<Transform> handleThis(this);
+    parent = newParent;
+    depth = newParent->depth + 1;
+    prevSibling = newParent->lastChild;
+    nextSibling = nullptr;
+    if(Transform* last = newParent->lastChild.get()) {
+        last->nextSibling = handleThis;
+    } else {
+        newParent->firstChild = handleThis;
+    }
+    newParent->lastChild = handleThis;
+    newParent->childCount++;
+}
+
+void Transform::detach()
+{
+    Transform* parentPtr = parent.get();
+    if(!parentPtr) {
+        return;
+    }
+    Transform* prev = prevSibling.get();
+    Transform* next = nextSibling.get();
+    if(prev) {
+        prev->nextSibling = nextSibling;
+    } else {
+        assert(parentPtr->firstChild.get() == this);
+        parentPtr->firstChild = nextSibling;
+    }
+    if(next) {
+        next->prevSibling = prevSibling;
+    } else {
+        assert(parentPtr->lastChild.get() == this);
+        parentPtr->lastChild = prevSibling;
+    }
+    parentPtr->childCount--;
+    parent = nullptr;
+    prevSibling = nullptr;
+    nextSibling = nullptr;
+    depth = 0;
 }
 
 string to_string(const TransformData& data)
@@ -138,72 +169,125 @@ TransformData TransformData::lerp(TransformData other, float alpha) const
 
 mat4 TransformData::toMat4() const
 {
-    return translate(mat4(1.0f), translation)
-        * mat4_cast(rotation)
-        * glm::scale(mat4(1.0f), scale);
+    // Equivalent to translate * rotate * scale, without the matrix products.
+    mat4 result = mat4_cast(rotation);
+    result[0] *= scale.x;
+    result[1] *= scale.y;
+    result[2] *= scale.z;
+    result[3] = vec4(translation, 1.0f);
+    return result;
+}
+
+void Transform::hashState(StateHasher& hasher) const
+{
+    hasher.add(relativeTransform.translation);
+    hasher.add(relativeTransform.rotation);
+    hasher.add(relativeTransform.scale);
+    Component::hashIdentity(hasher, parent.get());
 }
 
 void Transform::setRelativeTransform(const TransformData& relativeTransform)
 {
     this->relativeTransform = relativeTransform;
-    incrementUpdateId();
+    markLocalChanged();
 }
 
-void Transform::incrementUpdateId()
+// The last version handed out to a transform. Transforms are written by one system at a time, but different worlds
+// may tick on different threads.
+static atomic<uint64_t> lastTransformVersion(0);
+
+void Transform::markLocalChanged()
 {
-    updateId++;
+    localVersion = lastTransformVersion.fetch_add(1, memory_order_relaxed) + 1;
+    markGlobalChanged(localVersion);
 }
 
-uint Transform::sumUpdatesRelativeTo(shared_ptr<Transform> relative) const
+void Transform::markGlobalChanged(uint64_t version)
 {
-    if(relative.get() == this) {
-        return 0;
+    // The global transforms of all descendants move with this one.
+    markChanged();
+    worldVersion = version;
+    globalState.store(GLOBAL_DIRTY, memory_order_relaxed);
+    for(Transform* child = firstChild.get(); child; child = child->nextSibling.get()) {
+        child->depth = depth + 1;
+        child->markGlobalChanged(version);
     }
-    uint sum = updateId;
-    shared_ptr<Transform> curr = parent.lock();
+}
 
+bool Transform::changedRelativeToSince(const Transform* relative, uint64_t version) const
+{
+    if(relative == this || worldVersion <= version) {
+        return false;
+    }
+    // The latest change reached this transform without reaching the relative one, so it came from in between.
+    if(!relative || worldVersion > relative->worldVersion) {
+        return true;
+    }
+    // The latest change came from the relative transform or above, so look for an earlier one in between.
+    const Transform* curr = this;
     while(curr && curr != relative) {
-        sum += curr->updateId;
-
-        curr = curr->parent.lock();
+        if(curr->localVersion > version) {
+            return true;
+        }
+        curr = curr->parent.get();
     }
-    return sum;
+    // If the relative transform is not an ancestor, any change to it counts too.
+    return !curr && relative->worldVersion > version;
 }
 
-TransformData Transform::getGlobalTransform() const
+const TransformData& Transform::getGlobalTransform() const
 {
-    TransformData currTransform = relativeTransform;
-    shared_ptr<Transform> curr = parent.lock();
+    if(globalState.load(memory_order_acquire) != GLOBAL_CLEAN) {
+        updateGlobalTransform();
+    }
+    return globalTransform;
+}
 
-    while(curr) {
-        currTransform = curr->relativeTransform * currTransform;
+const mat4& Transform::getGlobalMatrix() const
+{
+    if(globalState.load(memory_order_acquire) != GLOBAL_CLEAN) {
+        updateGlobalTransform();
+    }
+    return globalMatrix;
+}
 
-        curr = curr->parent.lock();
+void Transform::updateGlobalTransform() const
+{
+    // Transforms are only written while nothing reads them, but several readers may find the same one dirty.
+    uchar expected = GLOBAL_DIRTY;
+    if(!globalState.compare_exchange_strong(expected, GLOBAL_UPDATING, memory_order_acquire)) {
+        while(globalState.load(memory_order_acquire) != GLOBAL_CLEAN) {
+            this_thread::yield();
+        }
+        return;
     }
-    return currTransform;
+    const Transform* par = parent.get();
+    globalTransform = par ? par->getGlobalTransform() * relativeTransform : relativeTransform;
+    globalMatrix = globalTransform.toMat4();
+    globalState.store(GLOBAL_CLEAN, memory_order_release);
 }
 
 void Transform::setGlobalTransform(const TransformData& globalTransform)
 {
     TransformData parentGlobal;
-    shared_ptr<Transform> par = parent.lock();
+    const Transform* par = parent.get();
     if(par) {
         parentGlobal = par->getGlobalTransform();
     }
     setRelativeTransform(parentGlobal.inverse() * globalTransform);
-    // setRelativeTransform changes the updateId for us, so we don't have to.
+    // setRelativeTransform changes the version for us, so we don't have to.
 }
 
-TransformData Transform::getTransformRelativeTo(shared_ptr<Transform> relative) const
+TransformData Transform::getTransformRelativeTo(const Transform* relative) const
 {
     if(!relative) {
         return getGlobalTransform();
     }
-    if(relative.get() == this) {
+    if(relative == this) {
         return TransformData();
     }
     TransformData currTransform = relativeTransform;
-    shared_ptr<Transform> curr = parent.lock();
+    const Transform* curr = parent.get();
 
     while(curr) {
         if(curr == relative) {
@@ -211,46 +295,33 @@ TransformData Transform::getTransformRelativeTo(shared_ptr<Transform> relative)
         }
         currTransform = curr->relativeTransform * currTransform;
 
-        curr = curr->parent.lock();
+        curr = curr->parent.get();
     }
     return relative->getGlobalTransform().inverse() * currTransform;
 }
 
-void Transform::setTransformRelativeTo(const TransformData& transform, shared_ptr<Transform> relative)
+void Transform::setTransformRelativeTo(const TransformData& transform, const Transform* relative)
 {
     if(!relative) {
         setGlobalTransform(transform);
         return;
     }
-    if(relative.get() == this) {
+    if(relative == this) {
         return;
     }
     TransformData parentRelative;
-    shared_ptr<Transform> par = parent.lock();
+    const Transform* par = parent.get();
     if(par) {
         parentRelative = par->getTransformRelativeTo(relative).inverse();
     } else {
         parentRelative = relative->getGlobalTransform();
     }
     setRelativeTransform(parentRelative * transform);
-    // setRelativeTransform changes the updateId for us, so we don't have to.
-}
-
-vector<shared_ptr<Transform>> Transform::getChildren() const
-{
-    vector<shared_ptr<Transform>> out;
-
-    for(const weak_ptr<Transform>& childPtr : children) {
-        shared_ptr<Transform> child = childPtr.lock();
-        if(child) {
-            out.push_back(child);
-        }
-    }
-
-    return out;
+    // setRelativeTransform changes the version for us, so we don't have to.
 }
 
 shared_ptr<Transform> mapToTransform(shared_ptr<Transformable> component)
 {
-    return component ? component->getTransform() : nullptr;
+    Transform* transform = component ? component->getTransform() : nullptr;
+    return transform ? static_pointer_cast<Transform>(transform->shared_from_this()) : nullptr;
 }
@@ -0,0 +1,198 @@
+#include "core/TransformHierarchy.h"
+
+#include <algorithm>
+
+// Reorders the values so that the value at each new slot is the one from the old slot it lists.
+template<typename T>
+static void permute(vector<T>& values, const vector<uint>& oldSlots)
+{
+    vector<T> sorted;
+    sorted.reserve(oldSlots.size());
+    for(uint oldSlot : oldSlots) {
+        sorted.push_back(values[oldSlot]);
+    }
+    values.swap(sorted);
+}
+
+uint TransformHierarchy::addNode(const TransformData& local, uint parent)
+{
+    uint node;
+    if(freeNodes.empty()) {
+        node = (uint)slots.size();
+        slots.push_back(FREE);
+        parents.push_back(NO_PARENT);
+    } else {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    uint slot = (uint)nodes.size();
+    slots[node] = slot;
+    parents[node] = parent;
+
+    nodes.push_back(node);
+    parentSlots.push_back(parent == NO_PARENT ? NO_PARENT : slots[parent]);
+    for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+        localFields[field].push_back(0.0f);
+        worldFields[field].push_back(0.0f);
+    }
+    localArrays().set(slot, local);
+    worldArrays().set(slot, local);
+    worldMatrices.push_back(mat4(1.0f));
+    dirty.push_back(1);
+    nodeCount++;
+    // Appending keeps parents before children, but the new node may not be in its depth's level.
+    needsSort = true;
+    return node;
+}
+
+void TransformHierarchy::removeNode(uint node)
+{
+    for(uint child = 0; child < parents.size(); child++) {
+        if(parents[child] == node && slots[child] != FREE) {
+            parents[child] = NO_PARENT;
+            dirty[slots[child]] = 1;
+        }
+    }
+    nodes[slots[node]] = FREE;
+    slots[node] = FREE;
+    parents[node] = NO_PARENT;
+    freeNodes.push_back(node);
+    nodeCount--;
+    needsSort = true;
+}
+
+void TransformHierarchy::setParent(uint node, uint parent)
+{
+    if(parents[node] == parent) {
+        return;
+    }
+    for(uint curr = parent; curr != NO_PARENT; curr = parents[curr]) {
+        if(curr == node) {
+            parent = NO_PARENT;
+            break;
+        }
+    }
+    parents[node] = parent;
+    dirty[slots[node]] = 1;
+    needsSort = true;
+}
+
+void TransformHierarchy::setLocalTransform(uint node, const TransformData& local)
+{
+    uint slot = slots[node];
+    localArrays().set(slot, local);
+    dirty[slot] = 1;
+}
+
+void TransformHierarchy::update(JobSystem* jobSystem, size_t grainSize)
+{
+    if(needsSort) {
+        sortByDepth();
+    }
+    // Nodes of the same depth never depend on each other, so each level can be batched and split freely.
+    for(size_t level = 0; level + 1 < levelStarts.size(); level++) {
+        size_t start = levelStarts[level];
+        size_t end = levelStarts[level + 1];
+        if(jobSystem) {
+            jobSystem->parallelFor(end - start, grainSize, [this, start](size_t first, size_t last) {
+                updateRange(start + first, start + last);
+            });
+        } else {
+            updateRange(start, end);
+        }
+    }
+    fill(dirty.begin(), dirty.end(), 0);
+}
+
+void TransformHierarchy::updateRange(size_t first, size_t last)
+{
+    // Composes and converts each run of dirty nodes in one kernel call each. The parents are in earlier levels, so
+    // gathering them never reads the world transforms being written.
+    // Every node in the range has the same depth, so either all of them are roots or none are.
+    bool roots = first < last && parentSlots[first] == NO_PARENT;
+    TransformArrays local = localArrays();
+    TransformArrays world = worldArrays();
+    size_t slot = first;
+    while(slot < last) {
+        while(slot < last && !propagateDirty(slot)) {
+            slot++;
+        }
+        size_t runStart = slot;
+        while(slot < last && propagateDirty(slot)) {
+            slot++;
+        }
+        size_t count = slot - runStart;
+        if(count == 0) {
+            break;
+        }
+        if(roots) {
+            for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+                copy_n(local.fields[field] + runStart, count, world.fields[field] + runStart);
+            }
+        } else {
+            composeTransforms(world, parentSlots.data() + runStart, local.offset(runStart), world.offset(runStart),
+                count);
+        }
+        transformsToMat4(world.offset(runStart), worldMatrices.data() + runStart, count);
+    }
+}
+
+void TransformHierarchy::sortByDepth()
+{
+    // Find the depth of every node, walking up only until an ancestor with a known depth.
+    const uint UNKNOWN = (uint)-1;
+    vector<uint> depths(slots.size(), UNKNOWN);
+    vector<uint> chain;
+    uint maxDepth = 0;
+    for(uint node = 0; node < slots.size(); node++) {
+        if(slots[node] == FREE || depths[node] != UNKNOWN) {
+            continue;
+        }
+        uint curr = node;
+        while(curr != NO_PARENT && depths[curr] == UNKNOWN) {
+            chain.push_back(curr);
+            curr = parents[curr];
+        }
+        uint depth = curr == NO_PARENT ? 0 : depths[curr] + 1;
+        while(!chain.empty()) {
+            depths[chain.back()] = depth++;
+            chain.pop_back();
+        }
+        maxDepth = std::max(maxDepth, depth - 1);
+    }
+
+    // Counting sort by depth, keeping the current order within each depth.
+    levelStarts.assign(nodeCount > 0 ? maxDepth + 2 : 1, 0);
+    for(uint node : nodes) {
+        if(node != FREE) {
+            levelStarts[depths[node] + 1]++;
+        }
+    }
+    for(size_t level = 1; level < levelStarts.size(); level++) {
+        levelStarts[level] += levelStarts[level - 1];
+    }
+    vector<uint> oldSlots(nodeCount);
+    vector<size_t> next(levelStarts.begin(), levelStarts.end() - 1);
+    for(uint slot = 0; slot < nodes.size(); slot++) {
+        if(nodes[slot] != FREE) {
+            oldSlots[next[depths[nodes[slot]]]++] = slot;
+        }
+    }
+
+    permute(nodes, oldSlots);
+    for(size_t field = 0; field < TRANSFORM_FIELDS; field++) {
+        permute(localFields[field], oldSlots);
+        permute(worldFields[field], oldSlots);
+    }
+    permute(worldMatrices, oldSlots);
+    permute(dirty, oldSlots);
+    for(uint slot = 0; slot < nodes.size(); slot++) {
+        slots[nodes[slot]] = slot;
+    }
+    parentSlots.resize(nodes.size());
+    for(uint slot = 0; slot < nodes.size(); slot++) {
+        uint parent = parents[nodes[slot]];
+        parentSlots[slot] = parent == NO_PARENT ? NO_PARENT : slots[parent];
+    }
+    needsSort = false;
+}
@@ -0,0 +1,138 @@
+#include "TransformKernelsImpl.h"
+
+#include <atomic>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+static constexpr TransformKernelTable scalarKernels = TRANSFORM_KERNEL_TABLE(ScalarLanes);
+#ifdef TRANSFORM_KERNELS_SSE2
+static constexpr TransformKernelTable sseKernels = TRANSFORM_KERNEL_TABLE(SseLanes);
+#endif
+#ifdef TRANSFORM_KERNELS_NEON
+static constexpr TransformKernelTable neonKernels = TRANSFORM_KERNEL_TABLE(NeonLanes);
+#endif
+
+// Does the CPU (and the OS, which has to save the wider registers) support AVX2 and FMA.
+static bool cpuSupportsAvx2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osSavesAvx = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && fma && (info[1] & (1 << 5));
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+static const TransformKernelTable* getKernelTable(SimdLevel level)
+{
+    switch(level) {
+    case SimdLevel::Scalar:
+        return &scalarKernels;
+#ifdef TRANSFORM_KERNELS_SSE2
+    case SimdLevel::SSE2:
+        return &sseKernels;
+#endif
+#ifdef TRANSFORM_KERNELS_NEON
+    case SimdLevel::NEON:
+        return &neonKernels;
+#endif
+    case SimdLevel::AVX2:
+        return cpuSupportsAvx2() ? avx2TransformKernels : nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+SimdLevel getSupportedSimdLevel()
+{
+    static const SimdLevel supported = []() {
+        for(SimdLevel level : { SimdLevel::AVX2, SimdLevel::NEON, SimdLevel::SSE2 }) {
+            if(getKernelTable(level)) {
+                return level;
+            }
+        }
+        return SimdLevel::Scalar;
+    }();
+    return supported;
+}
+
+// The level the kernels use, and its table. The table is read on every call, so it is cached separately.
+static atomic<SimdLevel> currentLevel(getSupportedSimdLevel());
+static atomic<const TransformKernelTable*> currentKernels(getKernelTable(getSupportedSimdLevel()));
+
+SimdLevel getSimdLevel()
+{
+    return currentLevel.load(memory_order_relaxed);
+}
+
+bool setSimdLevel(SimdLevel level)
+{
+    const TransformKernelTable* kernels = getKernelTable(level);
+    if(!kernels) {
+        return false;
+    }
+    currentLevel.store(level, memory_order_relaxed);
+    currentKernels.store(kernels, memory_order_relaxed);
+    return true;
+}
+
+string to_string(SimdLevel level)
+{
+    switch(level) {
+    case SimdLevel::Scalar: return "Scalar";
+    case SimdLevel::SSE2: return "SSE2";
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::NEON: return "NEON";
+    }
+    return "Unknown";
+}
+
+void composeTransforms(const TransformData* lhs, const TransformData* rhs, TransformData* out, size_t count)
+{
+    currentKernels.load(memory_order_relaxed)->compose(lhs, rhs, out, count);
+}
+
+void composeTransforms(const ConstTransformArrays& lhs, const ConstTransformArrays& rhs, const TransformArrays& out,
+    size_t count)
+{
+    currentKernels.load(memory_order_relaxed)->composeArrays(lhs, rhs, out, count);
+}
+
+void composeTransforms(const ConstTransformArrays& lhs, const uint* lhsIndices, const ConstTransformArrays& rhs,
+    const TransformArrays& out, size_t count)
+{
+    currentKernels.load(memory_order_relaxed)->composeIndexed(lhs, lhsIndices, rhs, out, count);
+}
+
+void invertTransforms(const TransformData* transforms, TransformData* out, size_t count)
+{
+    currentKernels.load(memory_order_relaxed)->invert(transforms, out, count);
+}
+
+void transformsToMat4(const TransformData* transforms, mat4* out, size_t count)
+{
+    currentKernels.load(memory_order_relaxed)->toMat4(transforms, out, count);
+}
+
+void transformsToMat4(const ConstTransformArrays& transforms, mat4* out, size_t count)
+{
+    currentKernels.load(memory_order_relaxed)->toMat4Arrays(transforms, out, count);
+}
+
+void transformPoints(const TransformData& transform, const vec3* points, vec3* out, size_t count)
+{
+    currentKernels.load(memory_order_relaxed)->transformPoints(transform, points, out, count);
+}
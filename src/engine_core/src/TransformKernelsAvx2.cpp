@@ -0,0 +1,14 @@
+// Built with AVX2 and FMA enabled on x86 (see CMakeLists.txt). Only reached once the CPU is known to support them.
+#include "TransformKernelsImpl.h"
+
+#ifdef TRANSFORM_KERNELS_AVX2
+
+// Constant initialized, so nothing in this file runs before the CPU has been checked.
+static constexpr TransformKernelTable avx2Kernels = TRANSFORM_KERNEL_TABLE(Avx2Lanes);
+extern const TransformKernelTable* const avx2TransformKernels = &avx2Kernels;
+
+#else
+
+extern const TransformKernelTable* const avx2TransformKernels = nullptr;
+
+#endif
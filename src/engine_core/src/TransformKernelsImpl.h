@@ -0,0 +1,542 @@
+#pragma once
+
+/*
+The transform kernels, written once over a lane type and compiled per instruction set. Each lane type holds
+WIDTH floats and provides arithmetic, a broadcast constructor, and contiguous, strided and indexed loads and stores,
+so the kernels process WIDTH transforms at a time and finish with single lanes. The kernels read transforms through a
+source and write them through a target, which hide whether they are TransformData structs or TransformArrays.
+Everything here has internal linkage, so translation units built with different instruction sets never share code.
+Do not call glm functions here for the same reason: their inline definitions would be compiled for the wider set.
+*/
+
+#include "core/TransformKernels.h"
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define TRANSFORM_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define TRANSFORM_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+// The kernels for one instruction set.
+struct TransformKernelTable
+{
+    void (*compose)(const TransformData* lhs, const TransformData* rhs, TransformData* out, size_t count);
+    void (*composeArrays)(const ConstTransformArrays& lhs, const ConstTransformArrays& rhs, const TransformArrays& out,
+        size_t count);
+    void (*composeIndexed)(const ConstTransformArrays& lhs, const uint* lhsIndices, const ConstTransformArrays& rhs,
+        const TransformArrays& out, size_t count);
+    void (*invert)(const TransformData* transforms, TransformData* out, size_t count);
+    void (*toMat4)(const TransformData* transforms, mat4* out, size_t count);
+    void (*toMat4Arrays)(const ConstTransformArrays& transforms, mat4* out, size_t count);
+    void (*transformPoints)(const TransformData& transform, const vec3* points, vec3* out, size_t count);
+};
+
+// Defined in TransformKernelsAvx2.cpp. nullptr if the kernels were not compiled for AVX2.
+extern const TransformKernelTable* const avx2TransformKernels;
+
+// Fills in a TransformKernelTable with the kernels for the lane type.
+#define TRANSFORM_KERNEL_TABLE(Lanes) { \
+    &composeKernel<Lanes>, &composeArraysKernel<Lanes>, &composeIndexedKernel<Lanes>, &invertKernel<Lanes>, \
+    &toMat4Kernel<Lanes>, &toMat4ArraysKernel<Lanes>, &transformPointsKernel<Lanes> \
+}
+
+namespace {
+
+// Float offsets of the fields of a TransformData, so any quat component order works.
+const size_t TRANSFORM_FLOATS = sizeof(TransformData) / sizeof(float);
+const size_t TRANSLATION = offsetof(TransformData, translation) / sizeof(float);
+const size_t ROTATION_W = (offsetof(TransformData, rotation) + offsetof(quat, w)) / sizeof(float);
+const size_t ROTATION_X = (offsetof(TransformData, rotation) + offsetof(quat, x)) / sizeof(float);
+const size_t ROTATION_Y = (offsetof(TransformData, rotation) + offsetof(quat, y)) / sizeof(float);
+const size_t ROTATION_Z = (offsetof(TransformData, rotation) + offsetof(quat, z)) / sizeof(float);
+const size_t SCALE = offsetof(TransformData, scale) / sizeof(float);
+const size_t VEC3_FLOATS = sizeof(vec3) / sizeof(float);
+const size_t MAT4_FLOATS = sizeof(mat4) / sizeof(float);
+// The offset in a TransformData of each float, in TransformArrays order.
+const size_t STRUCT_FIELDS[TRANSFORM_FIELDS] = {
+    TRANSLATION, TRANSLATION + 1, TRANSLATION + 2, ROTATION_W, ROTATION_X, ROTATION_Y, ROTATION_Z,
+    SCALE, SCALE + 1, SCALE + 2
+};
+
+static_assert(sizeof(TransformData) % sizeof(float) == 0, "TransformData must be made of floats.");
+static_assert(sizeof(TransformData) == TRANSFORM_FIELDS * sizeof(float), "TransformData must be packed.");
+static_assert(sizeof(vec3) == 3 * sizeof(float), "vec3 must be packed.");
+static_assert(sizeof(mat4) == 16 * sizeof(float), "mat4 must be packed.");
+
+struct ScalarLanes
+{
+    static const size_t WIDTH = 1;
+    float v;
+
+    ScalarLanes() {}
+    ScalarLanes(float f) : v(f) {}
+
+    static inline ScalarLanes load(const float* p) { return p[0]; }
+    static inline ScalarLanes load(const float* p, size_t stride) { return p[0]; }
+    static inline ScalarLanes load(const float* p, const uint* indices) { return p[indices[0]]; }
+    inline void store(float* p) const { p[0] = v; }
+    inline void store(float* p, size_t stride) const { p[0] = v; }
+
+    friend inline ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return a.v + b.v; }
+    friend inline ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return a.v - b.v; }
+    friend inline ScalarLanes operator*(ScalarLanes a, ScalarLanes b) { return a.v * b.v; }
+    friend inline ScalarLanes operator/(ScalarLanes a, ScalarLanes b) { return a.v / b.v; }
+    friend inline ScalarLanes operator-(ScalarLanes a) { return -a.v; }
+    // 1 / a, or 0 where a is 0, as in TransformData::inverse.
+    friend inline ScalarLanes reciprocalOrZero(ScalarLanes a) { return a.v == 0 ? 0.0f : 1.0f / a.v; }
+};
+
+#ifdef TRANSFORM_KERNELS_SSE2
+struct SseLanes
+{
+    static const size_t WIDTH = 4;
+    __m128 v;
+
+    SseLanes() {}
+    SseLanes(__m128 _v) : v(_v) {}
+    SseLanes(float f) : v(_mm_set1_ps(f)) {}
+
+    static inline SseLanes load(const float* p) { return _mm_loadu_ps(p); }
+    static inline SseLanes load(const float* p, size_t stride) {
+        return _mm_setr_ps(p[0], p[stride], p[2 * stride], p[3 * stride]);
+    }
+    static inline SseLanes load(const float* p, const uint* indices) {
+        return _mm_setr_ps(p[indices[0]], p[indices[1]], p[indices[2]], p[indices[3]]);
+    }
+    inline void store(float* p) const { _mm_storeu_ps(p, v); }
+    inline void store(float* p, size_t stride) const {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, v);
+        for(size_t i = 0; i < 4; i++) {
+            p[i * stride] = lanes[i];
+        }
+    }
+
+    friend inline SseLanes operator+(SseLanes a, SseLanes b) { return _mm_add_ps(a.v, b.v); }
+    friend inline SseLanes operator-(SseLanes a, SseLanes b) { return _mm_sub_ps(a.v, b.v); }
+    friend inline SseLanes operator*(SseLanes a, SseLanes b) { return _mm_mul_ps(a.v, b.v); }
+    friend inline SseLanes operator/(SseLanes a, SseLanes b) { return _mm_div_ps(a.v, b.v); }
+    friend inline SseLanes operator-(SseLanes a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+    friend inline SseLanes reciprocalOrZero(SseLanes a) {
+        __m128 nonZero = _mm_cmpneq_ps(a.v, _mm_setzero_ps());
+        return _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), a.v), nonZero);
+    }
+};
+#endif
+
+#ifdef TRANSFORM_KERNELS_AVX2
+struct Avx2Lanes
+{
+    static const size_t WIDTH = 8;
+    __m256 v;
+
+    Avx2Lanes() {}
+    Avx2Lanes(__m256 _v) : v(_v) {}
+    Avx2Lanes(float f) : v(_mm256_set1_ps(f)) {}
+
+    static inline Avx2Lanes load(const float* p) { return _mm256_loadu_ps(p); }
+    static inline Avx2Lanes load(const float* p, size_t stride) {
+        __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)stride));
+        return _mm256_i32gather_ps(p, offsets, sizeof(float));
+    }
+    static inline Avx2Lanes load(const float* p, const uint* indices) {
+        __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+        return _mm256_i32gather_ps(p, offsets, sizeof(float));
+    }
+    inline void store(float* p) const { _mm256_storeu_ps(p, v); }
+    inline void store(float* p, size_t stride) const {
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, v);
+        for(size_t i = 0; i < 8; i++) {
+            p[i * stride] = lanes[i];
+        }
+    }
+
+    friend inline Avx2Lanes operator+(Avx2Lanes a, Avx2Lanes b) { return _mm256_add_ps(a.v, b.v); }
+    friend inline Avx2Lanes operator-(Avx2Lanes a, Avx2Lanes b) { return _mm256_sub_ps(a.v, b.v); }
+    friend inline Avx2Lanes operator*(Avx2Lanes a, Avx2Lanes b) { return _mm256_mul_ps(a.v, b.v); }
+    friend inline Avx2Lanes operator/(Avx2Lanes a, Avx2Lanes b) { return _mm256_div_ps(a.v, b.v); }
+    friend inline Avx2Lanes operator-(Avx2Lanes a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+    friend inline Avx2Lanes reciprocalOrZero(Avx2Lanes a) {
+        __m256 nonZero = _mm256_cmp_ps(a.v, _mm256_setzero_ps(), _CMP_NEQ_UQ);
+        return _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), a.v), nonZero);
+    }
+};
+#endif
+
+#ifdef TRANSFORM_KERNELS_NEON
+struct NeonLanes
+{
+    static const size_t WIDTH = 4;
+    float32x4_t v;
+
+    NeonLanes() {}
+    NeonLanes(float32x4_t _v) : v(_v) {}
+    NeonLanes(float f) : v(vdupq_n_f32(f)) {}
+
+    static inline NeonLanes load(const float* p) { return vld1q_f32(p); }
+    static inline NeonLanes load(const float* p, size_t stride) {
+        float lanes[4] = { p[0], p[stride], p[2 * stride], p[3 * stride] };
+        return vld1q_f32(lanes);
+    }
+    static inline NeonLanes load(const float* p, const uint* indices) {
+        float lanes[4] = { p[indices[0]], p[indices[1]], p[indices[2]], p[indices[3]] };
+        return vld1q_f32(lanes);
+    }
+    inline void store(float* p) const { vst1q_f32(p, v); }
+    inline void store(float* p, size_t stride) const {
+        float lanes[4];
+        vst1q_f32(lanes, v);
+        for(size_t i = 0; i < 4; i++) {
+            p[i * stride] = lanes[i];
+        }
+    }
+
+    friend inline NeonLanes operator+(NeonLanes a, NeonLanes b) { return vaddq_f32(a.v, b.v); }
+    friend inline NeonLanes operator-(NeonLanes a, NeonLanes b) { return vsubq_f32(a.v, b.v); }
+    friend inline NeonLanes operator*(NeonLanes a, NeonLanes b) { return vmulq_f32(a.v, b.v); }
+    friend inline NeonLanes operator/(NeonLanes a, NeonLanes b) { return vdivq_f32(a.v, b.v); }
+    friend inline NeonLanes operator-(NeonLanes a) { return vnegq_f32(a.v); }
+    friend inline NeonLanes reciprocalOrZero(NeonLanes a) {
+        uint32x4_t zero = vceqq_f32(a.v, vdupq_n_f32(0.0f));
+        uint32x4_t reciprocal = vreinterpretq_u32_f32(vdivq_f32(vdupq_n_f32(1.0f), a.v));
+        return vreinterpretq_f32_u32(vbicq_u32(reciprocal, zero));
+    }
+};
+#endif
+
+// Reads consecutive TransformData structs, gathering each float with a strided load.
+struct StructSource
+{
+    const float* transforms;
+
+    template<typename V>
+    inline V load(size_t field) const { return V::load(transforms + STRUCT_FIELDS[field], TRANSFORM_FLOATS); }
+    inline StructSource at(size_t index) const { return { transforms + index * TRANSFORM_FLOATS }; }
+};
+
+struct StructTarget
+{
+    float* transforms;
+
+    template<typename V>
+    inline void store(size_t field, const V& value) const {
+        value.store(transforms + STRUCT_FIELDS[field], TRANSFORM_FLOATS);
+    }
+    inline StructTarget at(size_t index) const { return { transforms + index * TRANSFORM_FLOATS }; }
+};
+
+// Reads consecutive transforms from TransformArrays with contiguous loads.
+struct ArraySource
+{
+    const float* const* fields;
+    size_t index;
+
+    template<typename V>
+    inline V load(size_t field) const { return V::load(fields[field] + index); }
+    inline ArraySource at(size_t offset) const { return { fields, index + offset }; }
+};
+
+struct ArrayTarget
+{
+    float* const* fields;
+    size_t index;
+
+    template<typename V>
+    inline void store(size_t field, const V& value) const { value.store(fields[field] + index); }
+    inline ArrayTarget at(size_t offset) const { return { fields, index + offset }; }
+};
+
+// Reads the transforms at the listed indices of TransformArrays.
+struct IndexedArraySource
+{
+    const float* const* fields;
+    const uint* indices;
+
+    template<typename V>
+    inline V load(size_t field) const { return V::load(fields[field], indices); }
+    inline IndexedArraySource at(size_t offset) const { return { fields, indices + offset }; }
+};
+
+template<typename V>
+struct Vec3Lanes
+{
+    V x, y, z;
+};
+
+template<typename V>
+struct QuatLanes
+{
+    V w, x, y, z;
+};
+
+template<typename V>
+struct TransformLanes
+{
+    Vec3Lanes<V> translation;
+    QuatLanes<V> rotation;
+    Vec3Lanes<V> scale;
+};
+
+template<typename V, typename Source>
+inline TransformLanes<V> loadTransform(const Source& source)
+{
+    return {
+        { source.template load<V>(0), source.template load<V>(1), source.template load<V>(2) },
+        {
+            source.template load<V>(3), source.template load<V>(4), source.template load<V>(5),
+            source.template load<V>(6)
+        },
+        { source.template load<V>(7), source.template load<V>(8), source.template load<V>(9) }
+    };
+}
+
+template<typename V, typename Target>
+inline void storeTransform(const TransformLanes<V>& transform, const Target& target)
+{
+    target.store(0, transform.translation.x);
+    target.store(1, transform.translation.y);
+    target.store(2, transform.translation.z);
+    target.store(3, transform.rotation.w);
+    target.store(4, transform.rotation.x);
+    target.store(5, transform.rotation.y);
+    target.store(6, transform.rotation.z);
+    target.store(7, transform.scale.x);
+    target.store(8, transform.scale.y);
+    target.store(9, transform.scale.z);
+}
+
+template<typename V>
+inline Vec3Lanes<V> loadVec3(const float* p, size_t stride)
+{
+    return { V::load(p, stride), V::load(p + 1, stride), V::load(p + 2, stride) };
+}
+
+template<typename V>
+inline void storeVec3(const Vec3Lanes<V>& v, float* p, size_t stride)
+{
+    v.x.store(p, stride);
+    v.y.store(p + 1, stride);
+    v.z.store(p + 2, stride);
+}
+
+template<typename V>
+inline Vec3Lanes<V> cross(const Vec3Lanes<V>& a, const Vec3Lanes<V>& b)
+{
+    return { a.y * b.z - b.y * a.z, a.z * b.x - b.z * a.x, a.x * b.y - b.x * a.y };
+}
+
+// Rotates the vector by the quaternion, as glm's quat * vec3 does.
+template<typename V>
+inline Vec3Lanes<V> rotate(const QuatLanes<V>& q, const Vec3Lanes<V>& v)
+{
+    Vec3Lanes<V> axis = { q.x, q.y, q.z };
+    Vec3Lanes<V> uv = cross(axis, v);
+    Vec3Lanes<V> uuv = cross(axis, uv);
+    V two(2.0f);
+    return {
+        v.x + (uv.x * q.w + uuv.x) * two,
+        v.y + (uv.y * q.w + uuv.y) * two,
+        v.z + (uv.z * q.w + uuv.z) * two
+    };
+}
+
+template<typename V>
+inline QuatLanes<V> multiply(const QuatLanes<V>& p, const QuatLanes<V>& q)
+{
+    return {
+        p.w * q.w - p.x * q.x - p.y * q.y - p.z * q.z,
+        p.w * q.x + p.x * q.w + p.y * q.z - p.z * q.y,
+        p.w * q.y + p.y * q.w + p.z * q.x - p.x * q.z,
+        p.w * q.z + p.z * q.w + p.x * q.y - p.y * q.x
+    };
+}
+
+// lhs * rhs. See TransformData::operator*=.
+template<typename V>
+inline TransformLanes<V> compose(const TransformLanes<V>& lhs, const TransformLanes<V>& rhs)
+{
+    Vec3Lanes<V> scaled = {
+        lhs.scale.x * rhs.translation.x, lhs.scale.y * rhs.translation.y, lhs.scale.z * rhs.translation.z
+    };
+    Vec3Lanes<V> moved = rotate(lhs.rotation, scaled);
+    return {
+        { lhs.translation.x + moved.x, lhs.translation.y + moved.y, lhs.translation.z + moved.z },
+        multiply(lhs.rotation, rhs.rotation),
+        { lhs.scale.x * rhs.scale.x, lhs.scale.y * rhs.scale.y, lhs.scale.z * rhs.scale.z }
+    };
+}
+
+// See TransformData::inverse.
+template<typename V>
+inline TransformLanes<V> invert(const TransformLanes<V>& transform)
+{
+    const QuatLanes<V>& rotation = transform.rotation;
+    const Vec3Lanes<V>& scale = transform.scale;
+    // glm::inverse divides the conjugate by the squared length.
+    V lengthSquared = rotation.w * rotation.w + rotation.x * rotation.x + rotation.y * rotation.y
+        + rotation.z * rotation.z;
+    QuatLanes<V> inverseRotation = {
+        rotation.w / lengthSquared, -rotation.x / lengthSquared, -rotation.y / lengthSquared,
+        -rotation.z / lengthSquared
+    };
+    Vec3Lanes<V> inverseScale = { reciprocalOrZero(scale.x), reciprocalOrZero(scale.y), reciprocalOrZero(scale.z) };
+    Vec3Lanes<V> scaled = {
+        inverseScale.x * transform.translation.x, inverseScale.y * transform.translation.y,
+        inverseScale.z * transform.translation.z
+    };
+    Vec3Lanes<V> moved = rotate(inverseRotation, scaled);
+    return { { -moved.x, -moved.y, -moved.z }, inverseRotation, inverseScale };
+}
+
+// The columns of the rotation and scale part of a TRS matrix, as glm's mat4_cast followed by scaling.
+template<typename V>
+inline void basisLanes(const QuatLanes<V>& q, const Vec3Lanes<V>& scale, Vec3Lanes<V> columns[3])
+{
+    V xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    V xz = q.x * q.z, xy = q.x * q.y, yz = q.y * q.z;
+    V wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    V one(1.0f), two(2.0f);
+    columns[0] = { (one - two * (yy + zz)) * scale.x, two * (xy + wz) * scale.x, two * (xz - wy) * scale.x };
+    columns[1] = { two * (xy - wz) * scale.y, (one - two * (xx + zz)) * scale.y, two * (yz + wx) * scale.y };
+    columns[2] = { two * (xz + wy) * scale.z, two * (yz - wx) * scale.z, (one - two * (xx + yy)) * scale.z };
+}
+
+// Writes V::WIDTH consecutive matrices. See TransformData::toMat4.
+template<typename V>
+inline void storeMat4(const TransformLanes<V>& transform, float* out)
+{
+    Vec3Lanes<V> columns[3];
+    basisLanes(transform.rotation, transform.scale, columns);
+
+    V zero(0.0f), one(1.0f);
+    for(size_t column = 0; column < 3; column++) {
+        storeVec3(columns[column], out + column * 4, MAT4_FLOATS);
+        zero.store(out + column * 4 + 3, MAT4_FLOATS);
+    }
+    storeVec3(transform.translation, out + 12, MAT4_FLOATS);
+    one.store(out + 15, MAT4_FLOATS);
+}
+
+// Transforms V::WIDTH consecutive points by the TRS matrix with the provided columns.
+template<typename V>
+inline void transformPointLanes(const float matrix[12], const float* points, float* out)
+{
+    Vec3Lanes<V> point = loadVec3<V>(points, VEC3_FLOATS);
+    Vec3Lanes<V> result;
+    result.x = V(matrix[0]) * point.x + V(matrix[3]) * point.y + V(matrix[6]) * point.z + V(matrix[9]);
+    result.y = V(matrix[1]) * point.x + V(matrix[4]) * point.y + V(matrix[7]) * point.z + V(matrix[10]);
+    result.z = V(matrix[2]) * point.x + V(matrix[5]) * point.y + V(matrix[8]) * point.z + V(matrix[11]);
+    storeVec3(result, out, VEC3_FLOATS);
+}
+
+// out[i] = lhs[i] * rhs[i], V::WIDTH at a time and then one at a time.
+template<typename V, typename Lhs, typename Rhs, typename Target>
+inline void composeLoop(const Lhs& lhs, const Rhs& rhs, const Target& out, size_t count)
+{
+    size_t i = 0;
+    for(; i + V::WIDTH <= count; i += V::WIDTH) {
+        storeTransform(compose(loadTransform<V>(lhs.at(i)), loadTransform<V>(rhs.at(i))), out.at(i));
+    }
+    for(; i < count; i++) {
+        TransformLanes<ScalarLanes> composed =
+            compose(loadTransform<ScalarLanes>(lhs.at(i)), loadTransform<ScalarLanes>(rhs.at(i)));
+        storeTransform(composed, out.at(i));
+    }
+}
+
+template<typename V, typename Source>
+inline void toMat4Loop(const Source& transforms, float* out, size_t count)
+{
+    size_t i = 0;
+    for(; i + V::WIDTH <= count; i += V::WIDTH) {
+        storeMat4(loadTransform<V>(transforms.at(i)), out + i * MAT4_FLOATS);
+    }
+    for(; i < count; i++) {
+        storeMat4(loadTransform<ScalarLanes>(transforms.at(i)), out + i * MAT4_FLOATS);
+    }
+}
+
+template<typename V>
+void composeKernel(const TransformData* lhs, const TransformData* rhs, TransformData* out, size_t count)
+{
+    composeLoop<V>(StructSource{ reinterpret_cast<const float*>(lhs) },
+        StructSource{ reinterpret_cast<const float*>(rhs) }, StructTarget{ reinterpret_cast<float*>(out) }, count);
+}
+
+template<typename V>
+void composeArraysKernel(const ConstTransformArrays& lhs, const ConstTransformArrays& rhs, const TransformArrays& out,
+    size_t count)
+{
+    composeLoop<V>(ArraySource{ lhs.fields, 0 }, ArraySource{ rhs.fields, 0 }, ArrayTarget{ out.fields, 0 }, count);
+}
+
+template<typename V>
+void composeIndexedKernel(const ConstTransformArrays& lhs, const uint* lhsIndices, const ConstTransformArrays& rhs,
+    const TransformArrays& out, size_t count)
+{
+    composeLoop<V>(IndexedArraySource{ lhs.fields, lhsIndices }, ArraySource{ rhs.fields, 0 },
+        ArrayTarget{ out.fields, 0 }, count);
+}
+
+template<typename V>
+void invertKernel(const TransformData* transforms, TransformData* out, size_t count)
+{
+    StructSource in{ reinterpret_cast<const float*>(transforms) };
+    StructTarget target{ reinterpret_cast<float*>(out) };
+    size_t i = 0;
+    for(; i + V::WIDTH <= count; i += V::WIDTH) {
+        storeTransform(invert(loadTransform<V>(in.at(i))), target.at(i));
+    }
+    for(; i < count; i++) {
+        storeTransform(invert(loadTransform<ScalarLanes>(in.at(i))), target.at(i));
+    }
+}
+
+template<typename V>
+void toMat4Kernel(const TransformData* transforms, mat4* out, size_t count)
+{
+    toMat4Loop<V>(StructSource{ reinterpret_cast<const float*>(transforms) }, reinterpret_cast<float*>(out), count);
+}
+
+template<typename V>
+void toMat4ArraysKernel(const ConstTransformArrays& transforms, mat4* out, size_t count)
+{
+    toMat4Loop<V>(ArraySource{ transforms.fields, 0 }, reinterpret_cast<float*>(out), count);
+}
+
+template<typename V>
+void transformPointsKernel(const TransformData& transform, const vec3* points, vec3* out, size_t count)
+{
+    // Build the matrix once, then every point is three multiply-adds per coordinate.
+    StructSource source{ reinterpret_cast<const float*>(&transform) };
+    TransformLanes<ScalarLanes> lanes = loadTransform<ScalarLanes>(source);
+    Vec3Lanes<ScalarLanes> columns[3];
+    basisLanes(lanes.rotation, lanes.scale, columns);
+    float matrix[12] = {
+        columns[0].x.v, columns[0].y.v, columns[0].z.v,
+        columns[1].x.v, columns[1].y.v, columns[1].z.v,
+        columns[2].x.v, columns[2].y.v, columns[2].z.v,
+        lanes.translation.x.v, lanes.translation.y.v, lanes.translation.z.v
+    };
+    const float* pointFloats = reinterpret_cast<const float*>(points);
+    float* outFloats = reinterpret_cast<float*>(out);
+    size_t i = 0;
+    for(; i + V::WIDTH <= count; i += V::WIDTH) {
+        transformPointLanes<V>(matrix, pointFloats + i * VEC3_FLOATS, outFloats + i * VEC3_FLOATS);
+    }
+    for(; i < count; i++) {
+        transformPointLanes<ScalarLanes>(matrix, pointFloats + i * VEC3_FLOATS, outFloats + i * VEC3_FLOATS);
+    }
+}
+
+}
@@ -3,6 +3,27 @@
 #include "core/Entity.h"
 #include "core/Component.h"
 #include "core/World.h"
+#include "core/JobSystem.h"
+#include "core/Profiler.h"
+
+#include <chrono>
+
+Universe::Universe(uint workerThreads)
+    : jobSystem(new JobSystem(workerThreads))
+{ }
+
+Universe::~Universe()
+{
+    // Worlds may outlive the universe, so make sure they stop using its workers.
+    for(auto p : worlds) {
+        p->jobSystem = nullptr;
+    }
+}
+
+uint Universe::getDefaultWorkerThreads()
+{
+    return JobSystem::getDefaultWorkerCount();
+}
 
 shared_ptr<World> Universe::addWorld()
 {
@@ -14,6 +35,7 @@ shared_ptr<World> Universe::addWorld()
 void Universe::addWorld(shared_ptr<World> world)
 {
     worlds.push_back(world);
+    world->jobSystem = jobSystem.get();
 }
 
 shared_ptr<World> Universe::removeWorld(weak_ptr<World> world)
@@ -21,6 +43,7 @@ shared_ptr<World> Universe::removeWorld(weak_ptr<World> world)
     shared_ptr<World> wptr = world.lock();
     if(wptr) {
         worlds.erase(find(worlds.begin(), worlds.end(), wptr));
+        wptr->jobSystem = nullptr;
     }
     return wptr;
 }
@@ -28,25 +51,109 @@ shared_ptr<World> Universe::removeWorld(weak_ptr<World> world)
 
 void Universe::tick(float deltaTime)
 {
+    // Collect before the scope below starts, so every frame's samples include the previous Universe::tick.
+    PROFILE_COLLECT();
+    PROFILE_SCOPE("Universe::tick");
     totalTime += deltaTime;
-    float gameplayDelta = 1.0f / gameplayRate;
-    float remainingGameplayTime = totalTime - gameplayTime;
+    double gameplayDelta = 1.0 / gameplayRate;
+    double remainingGameplayTime = totalTime - gameplayTime;
     int desiredGameplayFrames = (int)(remainingGameplayTime * gameplayRate);
     int issuedGameplayFrames = desiredGameplayFrames < maxGameplayTicksPerFrame
         ? desiredGameplayFrames : maxGameplayTicksPerFrame;
 
-    for(int i = 0; i < issuedGameplayFrames; i++) {
-        gameplayTime += gameplayDelta;
-        for(auto p : worlds) {
-            p->gameplayTick(gameplayDelta);
-        }
+    for(auto p : worlds) {
+        p->lastTickTiming = World::TickTiming();
     }
+    runGameplayTicks(issuedGameplayFrames, gameplayDelta);
 
-    float currentSkippedTime = (desiredGameplayFrames - issuedGameplayFrames) * gameplayDelta;
+    double currentSkippedTime = (desiredGameplayFrames - issuedGameplayFrames) * gameplayDelta;
     skippedTime += currentSkippedTime;
     gameplayTime += currentSkippedTime;
 
+    if(parallelWorlds) {
+        // Every world has finished its gameplay ticks by now, so frame ticks see a consistent step.
+        forEachWorldInParallel([deltaTime](World& world) { runFrameTick(world, deltaTime); });
+    } else {
+        for(auto p : worlds) {
+            runFrameTick(*p, deltaTime);
+        }
+    }
+}
+
+void Universe::runTicks(uint64_t count)
+{
+    PROFILE_COLLECT();
+    PROFILE_SCOPE("Universe::runTicks");
+    double gameplayDelta = 1.0 / gameplayRate;
     for(auto p : worlds) {
-        p->frameTick(deltaTime);
+        p->lastTickTiming = World::TickTiming();
+    }
+    runGameplayTicks(count, gameplayDelta);
+    // Keep the wall clock in step, so a later tick does not try to catch up on this time.
+    totalTime += count * gameplayDelta;
+}
+
+uint64_t Universe::hashState() const
+{
+    StateHasher hasher;
+    hasher.add(gameplayTicks);
+    for(const shared_ptr<World>& world : worlds) {
+        world->hashState(hasher);
+    }
+    return hasher.getValue();
+}
+
+void Universe::runGameplayTicks(uint64_t count, double delta)
+{
+    float worldDelta = (float)delta;
+    if(parallelWorlds) {
+        // Worlds do not share state, so each one can run all of its gameplay ticks back to back.
+        forEachWorldInParallel([count, worldDelta](World& world) { runGameplayTicks(world, count, worldDelta); });
+    } else {
+        for(uint64_t i = 0; i < count; i++) {
+            for(auto p : worlds) {
+                runGameplayTicks(*p, 1, worldDelta);
+            }
+        }
+    }
+    gameplayTicks += count;
+    gameplayTime += count * delta;
+    simulatedTime += count * delta;
+}
+
+void Universe::runGameplayTicks(World& world, uint64_t ticks, float delta)
+{
+    auto start = chrono::steady_clock::now();
+    for(uint64_t i = 0; i < ticks; i++) {
+        world.gameplayTick(delta);
+    }
+    auto end = chrono::steady_clock::now();
+    world.lastTickTiming.gameplayTicks += (uint)ticks;
+    world.lastTickTiming.gameplaySeconds += chrono::duration<float>(end - start).count();
+}
+
+void Universe::runFrameTick(World& world, float delta)
+{
+    auto start = chrono::steady_clock::now();
+    world.frameTick(delta);
+    auto end = chrono::steady_clock::now();
+    world.lastTickTiming.frameSeconds = chrono::duration<float>(end - start).count();
+}
+
+void Universe::forEachWorldInParallel(const function<void(World&)>& fcn)
+{
+    JobCounter counter;
+    vector<World*> mainThreadWorlds;
+    for(const shared_ptr<World>& world : worlds) {
+        World* worldPtr = world.get();
+        if(worldPtr->hasMainThreadSystems()) {
+            mainThreadWorlds.push_back(worldPtr);
+        } else {
+            jobSystem->submit([worldPtr, &fcn]() { fcn(*worldPtr); }, &counter);
+        }
+    }
+    for(World* world : mainThreadWorlds) {
+        fcn(*world);
     }
+    jobSystem->wait(counter);
 }
@@ -0,0 +1,126 @@
+
+#include "core/View.h"
+#include "core/Entity.h"
+
+#include <algorithm>
+
+View::View(vector<uint> _types, vector<uint> _requiredTypes)
+    : types(move(_types)), requiredTypes(move(_requiredTypes))
+{
+    for(uint type : types) {
+        memberMask.set(type);
+    }
+    for(uint type : requiredTypes) {
+        requiredMask.set(type);
+    }
+}
+
+void View::clearChanges()
+{
+    for(const Handle<Component>& handle : added) {
+        indices[handle.get()].added = NOT_ADDED;
+    }
+    added.clear();
+    removed.clear();
+}
+
+bool View::ownerMatches(const Component& component, const Component* ignored) const
+{
+    if(requiredMask.none()) {
+        return true;
+    }
+    const Entity* owner = component.getOwnerHandle().get();
+    if(!owner) {
+        return false;
+    }
+    ComponentMask mask = owner->getComponentMask();
+    if(ignored && mask.test(ignored->getTypeId())) {
+        // The ignored component only counts if it is not the last of its type.
+        bool hasOther = false;
+        for(const Component& sibling : owner->findComponentsByType(ignored->getTypeId())) {
+            if(&sibling != ignored) {
+                hasOther = true;
+                break;
+            }
+        }
+        if(!hasOther) {
+            mask.reset(ignored->getTypeId());
+        }
+    }
+    return (mask & requiredMask) == requiredMask;
+}
+
+void View::insert(Component* component)
+{
+    if(!indices.emplace(component, MemberIndex{ members.size(), added.size() }).second) {
+        return;
+    }
+    members.push_back(component);
+    added.push_back(component->getHandle());
+}
+
+void View::erase(Component* component)
+{
+    auto it = indices.find(component);
+    if(it == indices.end()) {
+        return;
+    }
+    MemberIndex index = it->second;
+    indices.erase(it);
+    Component* last = members.back();
+    members.pop_back();
+    if(last != component) {
+        members[index.member] = last;
+        indices[last].member = index.member;
+    }
+
+    // A component that joined since the last clearChanges never needs to be reported.
+    if(index.added == NOT_ADDED) {
+        removed.push_back(component->getHandle());
+        return;
+    }
+    Handle<Component> lastAdded = added.back();
+    added.pop_back();
+    if(index.added != added.size()) {
+        added[index.added] = lastAdded;
+        indices[lastAdded.get()].added = index.added;
+    }
+}
+
+void View::onComponentAdded(Component* component)
+{
+    if(isMemberType(component->getTypeId()) && ownerMatches(*component, nullptr)) {
+        insert(component);
+    }
+    if(!isRequiredType(component->getTypeId())) {
+        return;
+    }
+    // The new component may complete the requirements of its siblings.
+    const Entity* owner = component->getOwnerHandle().get();
+    if(!owner) {
+        return;
+    }
+    for(const shared_ptr<Component>& sibling : owner->components) {
+        if(isMemberType(sibling->getTypeId()) && !contains(sibling.get()) && ownerMatches(*sibling, nullptr)) {
+            insert(sibling.get());
+        }
+    }
+}
+
+void View::onComponentRemoved(Component* component)
+{
+    erase(component);
+    if(!isRequiredType(component->getTypeId())) {
+        return;
+    }
+    // Without this component, its siblings may no longer meet the requirements.
+    const Entity* owner = component->getOwnerHandle().get();
+    if(!owner) {
+        return;
+    }
+    for(const shared_ptr<Component>& sibling : owner->components) {
+        if(sibling.get() != component && contains(sibling.get()) && !ownerMatches(*sibling, component)) {
+            erase(sibling.get());
+        }
+    }
+}
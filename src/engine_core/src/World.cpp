@@ -4,6 +4,26 @@
 #include "core/Entity.h"
 #include "core/Component.h"
 #include "core/System.h"
+#include "core/BudgetedSystem.h"
+#include "core/Profiler.h"
+
+#include <algorithm>
+
+World::World()
+    : pools(PoolSet::create())
+{
+    commands.pools = pools;
+}
+
+World::~World()
+{
+    // Components can outlive the world, so stop them from reading its tick.
+    for(const ComponentStorage& storage : components) {
+        for(size_t i = 0; i < storage.size(); i++) {
+            storage.data()[i]->worldTick = nullptr;
+        }
+    }
+}
 
 Query<shared_ptr<Entity>> World::queryEntities()
 {
@@ -12,14 +32,18 @@ Query<shared_ptr<Entity>> World::queryEntities()
 
 Query<shared_ptr<Component>> World::queryComponents(uint type)
 {
-    auto it = components.find(type);
-    return Query<shared_ptr<Component>>(
-        it == components.end() ? hash_set<shared_ptr<Component>>() : it->second);
+    hash_set<shared_ptr<Component>> items;
+    ComponentRange<Component> range = getComponentsOfType<Component>(type);
+    items.reserve(range.size());
+    for(Component& component : range) {
+        items.insert(component.shared_from_this());
+    }
+    return Query<shared_ptr<Component>>(items);
 }
 
 shared_ptr<Entity> World::addEntity()
 {
-    shared_ptr<Entity> ptr = make_shared<Entity>();
+    shared_ptr<Entity> ptr = makePooled<Entity>(pools);
     addEntity(ptr);
     return ptr;
 }
@@ -37,55 +61,193 @@ void World::addEntity(shared_ptr<Entity> entity)
 {
     entities.insert(entity);
     entity->world = shared_from_this();
+    if(!entity->pools) {
+        entity->pools = pools;
+    }
     for(const shared_ptr<Component>& child : entity->components) {
         addComponent(child);
     }
 }
 
+shared_ptr<View> World::addView(vector<uint> types, vector<uint> requiredTypes)
+{
+    shared_ptr<View> view(new View(move(types), move(requiredTypes)));
+    for(uint type : view->types) {
+        for(Component& component : getComponentsOfType<Component>(type)) {
+            if(view->ownerMatches(component, nullptr)) {
+                view->insert(&component);
+            }
+        }
+    }
+    views.push_back(view);
+    return view;
+}
+
+void World::removeView(shared_ptr<View> view)
+{
+    auto it = find(views.begin(), views.end(), view);
+    if(it != views.end()) {
+        views.erase(it);
+    }
+}
+
 void World::addSystem(shared_ptr<System> system)
 {
     system->world = shared_from_this();
+#ifdef ENGINE_PROFILING
+    // Interned once here, so profiling a tick never takes the profiler's lock.
+    system->profileName = Profiler::get().internTypeName(typeid(*system));
+#endif
     for(auto it = systems.begin(); it != systems.end(); it++) {
         if((*it)->priority <= system->priority) {
             systems.insert(it, system);
+            scheduler.invalidate();
             return;
         }
     }
     systems.push_back(system);
+    scheduler.invalidate();
 }
 
-void World::frameTick(float delta)
+void World::hashState(StateHasher& hasher) const
+{
+    // Dense type ids depend on the order types were first used in, so order by stable id instead.
+    vector<pair<uint, uint>> types;
+    for(uint type = 0; type < components.size(); type++) {
+        if(!components[type].empty()) {
+            types.push_back(make_pair(getStableComponentTypeId(type), type));
+        }
+    }
+    sort(types.begin(), types.end());
+    for(const pair<uint, uint>& type : types) {
+        const ComponentStorage& storage = components[type.second];
+        hasher.add(type.first);
+        hasher.add((uint64_t)storage.size());
+        for(size_t i = 0; i < storage.size(); i++) {
+            const Component* component = storage.data()[i];
+            component->hashState(hasher);
+            // Which entity owns the component, named by the entity's first component.
+            const Entity* owner = component->getOwnerHandle().get();
+            Component::hashIdentity(hasher, owner && !owner->components.empty() ? owner->components[0].get() : nullptr);
+        }
+    }
+}
+
+vector<World::BudgetReport> World::getBudgetReports() const
 {
-    for(shared_ptr<System> system : systems) {
+    vector<BudgetReport> reports;
+    for(const shared_ptr<System>& system : systems) {
+        shared_ptr<BudgetedSystem> budgeted = dynamic_pointer_cast<BudgetedSystem>(system);
+        if(!budgeted) {
+            continue;
+        }
+        BudgetReport report;
+        report.system = budgeted;
+        report.budgetMilliseconds = budgeted->budgetMilliseconds;
+        report.lastMilliseconds = budgeted->getLastMilliseconds();
+        report.backlog = budgeted->getBacklog();
+        report.framesBehind = budgeted->getFramesBehind();
+        reports.push_back(report);
+    }
+    return reports;
+}
+
+bool World::hasMainThreadSystems() const
+{
+    for(const shared_ptr<System>& system : systems) {
+        if(system->mainThreadOnly) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void World::initSystems()
+{
+    for(const shared_ptr<System>& system : systems) {
         if(!system->initialized) {
             system->initialized = true;
             system->init();
         }
-        system->frameTick(delta);
     }
 }
 
+void World::frameTick(float delta)
+{
+    PROFILE_SCOPE("World::frameTick");
+    uint tick = ++changeTick;
+    initSystems();
+    scheduler.run(systems, jobSystem, [this, delta, tick](System& system) {
+        PROFILE_SCOPE(system.profileName);
+        TaskFramePoolScope framePools(pools.get());
+        system.frameTick(delta);
+        system.lastFrameTick = tick;
+    });
+    flushCommands();
+}
+
 void World::gameplayTick(float delta)
 {
-    for(shared_ptr<System> system : systems) {
-        if(!system->initialized) {
-            system->initialized = true;
-            system->init();
+    PROFILE_SCOPE("World::gameplayTick");
+    uint tick = ++changeTick;
+    events.swap();
+    initSystems();
+    scheduler.run(systems, jobSystem, [this, delta, tick](System& system) {
+        PROFILE_SCOPE(system.profileName);
+        TaskFramePoolScope framePools(pools.get());
+        system.gameplayTick(delta);
+        system.lastGameplayTick = tick;
+    });
+    {
+        PROFILE_SCOPE("World::tasks");
+        TaskFramePoolScope framePools(pools.get());
+        tasks.update(delta);
+    }
+    flushCommands();
+}
+
+void World::flushCommands()
+{
+    PROFILE_SCOPE("World::flushCommands");
+    commands.apply(*this);
+}
+
+void World::reserve(size_t extraEntities, const vector<size_t>& extraComponents)
+{
+    entities.reserve(entities.size() + extraEntities);
+    if(extraComponents.size() > components.size()) {
+        components.resize(extraComponents.size());
+    }
+    for(uint type = 0; type < extraComponents.size(); type++) {
+        if(extraComponents[type] > 0) {
+            components[type].grow(extraComponents[type]);
         }
-        system->gameplayTick(delta);
     }
 }
 
 void World::addComponent(shared_ptr<Component> component)
 {
-    auto pair = components.insert(make_pair(component->getTypeId(), hash_set<shared_ptr<Component>>()));
-    pair.first->second.insert(component);
+    uint type = component->getTypeId();
+    if(type >= components.size()) {
+        components.resize(type + 1);
+    }
+    components[type].add(component.get());
+    component->worldTick = &changeTick;
+    component->addedTick = changeTick;
+    component->changedTick = changeTick;
+    for(const shared_ptr<View>& view : views) {
+        view->onComponentAdded(component.get());
+    }
 }
 
 void World::removeComponent(shared_ptr<Component> component)
 {
-    auto it = components.find(component->getTypeId());
-    if(it != components.end()) {
-        it->second.erase(component);
+    for(const shared_ptr<View>& view : views) {
+        view->onComponentRemoved(component.get());
+    }
+    uint type = component->getTypeId();
+    if(type < components.size()) {
+        components[type].remove(component.get());
     }
+    component->worldTick = nullptr;
 }
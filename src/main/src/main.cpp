@@ -9,6 +9,7 @@
 #include "core/World.h"
 #include "core/Entity.h"
 #include "core/Component.h"
+#include "core/Profiler.h"
 
 #include "std.h"
 
@@ -34,6 +35,7 @@
 #include "physics/KinematicBody.h"
 #include "physics/Trigger.h"
 #include "physics/RigidBody.h"
+#include "physics/PhysicsEvents.h"
 
 #include "ui/UISystem.h"
 #include "ui/ContainerLayouts.h"
@@ -84,25 +86,32 @@ public:
 class GravitySystem : public System
 {
 public:
+    GravitySystem() {
+        declareAccess({ get_id(GravityRegion), get_id(Trigger), get_id(ApplyGravity) }, { get_id(RigidBody) });
+    }
+
     virtual void gameplayTick(float delta) override {
-        auto regionQuery = getWorld()->queryComponents(get_id(GravityRegion))
-            .map_ptr<Trigger>(mapToSibling<Trigger>)
-            .map_group_ptr<CollisionObject>([](shared_ptr<Trigger> t){ return t->getOverlaps(); });
-        auto bodyQuery = getWorld()->queryComponents(get_id(ApplyGravity))
-            .map_ptr<RigidBody>(mapToSibling<RigidBody>);
-        for(shared_ptr<RigidBody> body : bodyQuery) {
-            if(regionQuery.contains(body)) {
-                body->addForce(vec3(0, -10, 0) * body->mass);
+        shared_ptr<World> world = getWorld();
+        hash_set<CollisionObject*> regionOverlaps;
+        world->each<const GravityRegion, const Trigger>(
+            [&regionOverlaps](const GravityRegion&, const Trigger& trigger) {
+                for(const Handle<CollisionObject>& overlap : trigger.getOverlapHandles()) {
+                    regionOverlaps.insert(overlap.get());
+                }
+            });
+        world->each<const ApplyGravity, RigidBody>([&regionOverlaps](const ApplyGravity&, RigidBody& body) {
+            if(regionOverlaps.count(&body) > 0) {
+                body.addForce(vec3(0, -10, 0) * body.mass);
             }
-        }
+        });
     }
 };
 
 class Bounce;
 
-void spawnBox(shared_ptr<World> world, vec3 point)
+void spawnBox(CommandBuffer& commands, vec3 point)
 {
-    shared_ptr<Entity> box = world->addEntity();
+    shared_ptr<Entity> box = commands.spawnEntity();
 
     shared_ptr<MeshRenderer> m = box->addComponent<MeshRenderer>();
     m->mesh = 7;
@@ -143,12 +152,10 @@ public:
                 ISptr->setTargetWindow(nullptr);
             }
         }
-        Query<shared_ptr<Transform>> c = getWorld()->queryComponents(get_id(ControlledEntity))
-            .map_ptr<Camera>(mapToSibling<Camera>)
-            .map_ptr<Transform>(mapToTransform);
-        for(shared_ptr<Transform> transform : c) {
+        getWorld()->each<const ControlledEntity, const Camera>([&ISptr](const ControlledEntity&, const Camera& camera) {
+            Transform* transform = camera.getTransform();
             if(!transform) {
-                continue;
+                return;
             }
             TransformData td = transform->getRelativeTransform();
             vec3 eulerRot = toAxisRotator(td.rotation);
@@ -156,24 +163,23 @@ public:
             eulerRot.y = clamp(eulerRot.y - ISptr->getActionValue(0, "lookPitch", false) * 0.1f, -89.f, 89.f);
             td.rotation = fromAxisRotator(eulerRot);
             transform->setRelativeTransform(td);
-        }
+        });
     }
     virtual void gameplayTick(float delta) override {
         shared_ptr<InputSystem> ISptr = IS.lock();
-        Query<shared_ptr<Transform>> c = getWorld()->queryComponents(get_id(ControlledEntity))
-            .map_ptr<Camera>(mapToSibling<Camera>)
-            .map_ptr<Transform>(mapToTransform);
-        for(shared_ptr<Transform> transform : c) {
-            if(!transform) {
-                continue;
-            }
-            TransformData td = transform->getRelativeTransform();
+        getWorld()->each<const ControlledEntity, const Camera>(
+            [&ISptr, delta](const ControlledEntity&, const Camera& camera) {
+                Transform* transform = camera.getTransform();
+                if(!transform) {
+                    return;
+                }
+                TransformData td = transform->getRelativeTransform();
             
-            td.translation += (td.rotation * vec3(0,0,-1)) * ISptr->getActionValue(0, "forward", true) * delta * 5.f;
-            td.translation += (td.rotation * vec3(-1,0,0)) * ISptr->getActionValue(0, "left", true) * delta * 5.f;
-            td.translation += (td.rotation * vec3(0,1,0)) * ISptr->getActionValue(0, "up", true) * delta * 5.f;
-            transform->setRelativeTransform(td);
-        }
+                td.translation += (td.rotation * vec3(0,0,-1)) * ISptr->getActionValue(0, "forward", true) * delta * 5.f;
+                td.translation += (td.rotation * vec3(-1,0,0)) * ISptr->getActionValue(0, "left", true) * delta * 5.f;
+                td.translation += (td.rotation * vec3(0,1,0)) * ISptr->getActionValue(0, "up", true) * delta * 5.f;
+                transform->setRelativeTransform(td);
+            });
     }
 };
 
@@ -194,13 +200,14 @@ public:
                 return;
             }
             lmb_down = true;
-            Query<shared_ptr<Transform>> t = getWorld()->queryComponents(get_id(ControlledEntity))
-                .map_ptr<Camera>(mapToSibling<Camera>)
-                .map_ptr<Transform>(mapToTransform);
-            for(shared_ptr<Transform> transform : t) {
-                TransformData td = transform->getGlobalTransform();
-                spawnBox(getWorld(), td.transformPoint(vec3(0, 0, -5)));
-            }
+            CommandBuffer& commands = getWorld()->getCommandBuffer();
+            getWorld()->each<const ControlledEntity, const Camera>(
+                [&commands](const ControlledEntity&, const Camera& camera) {
+                    if(Transform* transform = camera.getTransform()) {
+                        TransformData td = transform->getGlobalTransform();
+                        spawnBox(commands, td.transformPoint(vec3(0, 0, -5)));
+                    }
+                });
         }
         else {
             lmb_down = false;
@@ -211,19 +218,22 @@ public:
                 return;
             }
             rmb_down = true;
-            Query<shared_ptr<Transform>> t = getWorld()->queryComponents(get_id(ControlledEntity))
-                .map_ptr<Camera>(mapToSibling<Camera>)
-                .map_ptr<Transform>(mapToTransform);
-            for(shared_ptr<Transform> transform : t) {
-                TransformData td = transform->getGlobalTransform();
-                RaycastHit hit = PSptr->rayCast(td.translation, td.forward(), 10000, transform->getOwner());
-                if(hit) {
-                    shared_ptr<CollisionObject> obj = hit.obj.lock();
-                    if(obj->getTypeId() == get_id(RigidBody)) {
-                        getWorld()->removeEntity(obj->getOwner());
+            CommandBuffer& commands = getWorld()->getCommandBuffer();
+            getWorld()->each<const ControlledEntity, const Camera>(
+                [&commands, &PSptr](const ControlledEntity&, const Camera& camera) {
+                    Transform* transform = camera.getTransform();
+                    if(!transform) {
+                        return;
                     }
-                }
-            }
+                    TransformData td = transform->getGlobalTransform();
+                    RaycastHit hit = PSptr->rayCast(td.translation, td.forward(), 10000, transform->getOwner());
+                    if(hit) {
+                        CollisionObject* obj = hit.getObj();
+                        if(obj->getTypeId() == get_id(RigidBody)) {
+                            commands.removeEntity(obj->getOwner());
+                        }
+                    }
+                });
         }
         else {
             rmb_down = false;
@@ -243,16 +253,14 @@ public:
     float impulse = 2.5f;
 
     virtual void gameplayTick(float delta) override {
-        auto query = getWorld()->queryComponents(get_id(Bounce))
-            .map_ptr<RigidBody>(mapToSibling<RigidBody>);
-        for(shared_ptr<RigidBody> body : query) {
-            for(CollisionObject::Hit& hit : body->getHits()) {
-                if(hit.other.lock()->getTypeId() == get_id(Trigger)) {
-                    continue;
-                }
-                for(CollisionObject::Contact& contact : hit.contacts) {
-                    body->addPointImpulse(impulse * contact.normal, contact.worldPoint);
-                }
+        for(const ContactEvent& event : getWorld()->getEventBus().read<ContactEvent>()) {
+            CollisionObject* object = event.object.get();
+            CollisionObject* other = event.other.get();
+            if(!object || !other || object->getTypeId() != get_id(RigidBody) || other->getTypeId() == get_id(Trigger)) {
+                continue;
+            }
+            if(getSibling<Bounce>(*object)) {
+                static_cast<RigidBody*>(object)->addPointImpulse(impulse * event.contact.normal, event.contact.worldPoint);
             }
         }
     }
@@ -471,8 +479,9 @@ int main()
                 rand() * 1.f / RAND_MAX * 10 - 5.f,
                 rand() * 1.f / RAND_MAX * 5,
                 rand() * 1.f / RAND_MAX * 10 - 5.f);
-            spawnBox(w, point);
+            spawnBox(w->getCommandBuffer(), point);
         }
+        w->flushCommands();
         
         shared_ptr<Entity> camera = w->addEntity();
         {
@@ -504,10 +513,21 @@ int main()
         if(fpsTime >= 1) {
             fpsTime -= 1;
             cout << "FPS: " << (1.0f / delta) << endl;
+#ifdef ENGINE_PROFILING
+            for(const ProfileSummary& summary : Profiler::get().getSummary()) {
+                printf("  %-32s min %7.3fms  avg %7.3fms  p99 %7.3fms\n",
+                    summary.name, summary.min, summary.average, summary.p99);
+            }
+#endif
         }
 
         U.tick(delta);
     } while(running && !window.wantsClose());
 
+#ifdef ENGINE_PROFILING
+    PROFILE_COLLECT();
+    Profiler::get().writeChromeTrace("trace.json");
+#endif
+
     return 0;
 }
@@ -13,6 +13,7 @@ public:
     inline vec3 getExtents() const { return extents; }
 
     virtual btCollisionShape* constructShape() override;
+    virtual void hashState(StateHasher& hasher) const override;
 protected:
     vec3 extents = vec3(1,1,1);
 };
@@ -12,11 +12,15 @@ public:
 
     virtual class btCollisionObject* constructObject(class btCollisionShape* shape, class btMotionState* motion) = 0;
 
-    vector<weak_ptr<Collider>> colliders;
+    vector<Handle<Collider>> colliders;
 
-    vector<shared_ptr<Collider>> getColliders();
+    // Returns the colliders that are still alive.
+    vector<Collider*> getColliders() const;
 
     btCollisionObject* getBody() const { return body; }
+
+    // Hashes the transform and which colliders make up the body.
+    virtual void hashState(StateHasher& hasher) const override;
     
     struct Contact
     {
@@ -29,20 +33,8 @@ public:
             : worldPoint(_worldPoint), localPoint(_localPoint), normal(_normal) {}
     };
 
-    struct Hit
-    {
-        weak_ptr<CollisionObject> other;
-        vector<Contact> contacts;
-    };
-
-    inline vector<Hit> getHits() const { return hits; }
-    Hit* findHit(shared_ptr<CollisionObject> other);
 private:
-    Hit* findOrCreateHit(shared_ptr<CollisionObject> other);
-
     btCollisionObject* body = nullptr;
 
-    vector<Hit> hits;
-
     friend class PhysicsSystem;
 };
@@ -13,6 +13,8 @@ public:
     void setConvexHull(ResourceRef<ConvexHull> newHull);
     
     virtual btCollisionShape* constructShape() override;
+    // Hashes the resource id of the hull, since the hull itself is shared and never changes once loaded.
+    virtual void hashState(StateHasher& hasher) const override;
 protected:
     ResourceRef<ConvexHull> convexHull;
 };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "std.h"
+#include "physics/CollisionObject.h"
+
+class Trigger;
+
+/*
+A contact point between two collision objects, published on the world's event bus after every simulation step.
+Each contact is published once for each of the two objects, with the point and normal as seen from that object.
+*/
+struct ContactEvent
+{
+    Handle<CollisionObject> object; // The object the contact is reported for.
+    Handle<CollisionObject> other; // The object it touched.
+    CollisionObject::Contact contact; // The normal points away from other.
+};
+
+// An object starting or stopping overlapping a trigger, published on the world's event bus.
+struct TriggerEvent
+{
+    Handle<Trigger> trigger;
+    Handle<CollisionObject> other;
+    bool entered; // True when the overlap started, false when it ended.
+};
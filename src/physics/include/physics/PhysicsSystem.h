@@ -3,9 +3,11 @@
 
 #include "std.h"
 #include "core/System.h"
+#include "physics/CollisionObject.h"
 #include <glm/glm.hpp>
 
 class Entity;
+class View;
 class Collider;
 class CollisionObject;
 class ConvexHull;
@@ -16,9 +18,9 @@ struct RaycastHit
     vec3 point;
     float fraction;
     vec3 normal;
-    weak_ptr<CollisionObject> obj;
+    Handle<CollisionObject> obj;
 
-    inline shared_ptr<CollisionObject> getObj() const { return obj.lock(); }
+    inline CollisionObject* getObj() const { return obj.get(); }
 
     operator bool() const {
         return valid;
@@ -28,6 +30,7 @@ struct RaycastHit
 class PhysicsSystem : public System
 {
 public:
+    PhysicsSystem();
     virtual ~PhysicsSystem();
 
     virtual void init() override;
@@ -166,25 +169,32 @@ protected:
         class btCompoundShape* compoundShape;
         class btMotionState* motionState;
         Type type;
-        uint updateId;
-        std::map<std::weak_ptr<Collider>,
-            std::pair<class btCollisionShape*, uint>,
-            std::owner_less<>> shapeMap;
+        uint64_t version; // The world version of the body transform when last synced (see Transform::getWorldVersion).
+        std::map<Handle<Collider>, std::pair<class btCollisionShape*, uint64_t>> shapeMap;
     };
 
     friend class TransformMotionState;
 
-    std::map<std::weak_ptr<CollisionObject>, CollisionObjectData, std::owner_less<>> collisionObjects;
-    std::map<btCollisionObject*, std::weak_ptr<CollisionObject>> reverseObjects;
+    std::map<Handle<CollisionObject>, CollisionObjectData> collisionObjects;
+    std::map<btCollisionObject*, Handle<CollisionObject>> reverseObjects;
+
+    shared_ptr<View> bodies; // Every body component in the world.
+    vector<Handle<CollisionObject>> pendingBodies; // Bodies in the world that have no colliders yet.
+    vector<Handle<CollisionObject>> previousOverlaps; // Scratch space for a trigger's overlaps from the last step.
 
     // Deletes everything associated with the specified body (does not remove the body from the collisionObjects map).
     void cleanUpCollisionObject(CollisionObjectData& body);
     // Constructs a new collisionObject from its component.
-    void setUpCollisionObject(shared_ptr<CollisionObject>& bodyComponent);
+    void setUpCollisionObject(CollisionObject* bodyComponent);
+    /*
+    Could the colliders of the object differ from its collision shape: a collider was added or destroyed, changed since
+    the last gameplay tick, or moved relative to the body. Much cheaper than updateCollidersOfObject.
+    */
+    bool collidersMayHaveChanged(CollisionObject* bodyComponent, const CollisionObjectData& bodyData) const;
     // Updates the existing collision object to match the collider components.
-    void updateCollidersOfObject(shared_ptr<CollisionObject>& bodyComponent, CollisionObjectData& bodyData);
+    void updateCollidersOfObject(CollisionObject* bodyComponent, CollisionObjectData& bodyData);
     // Updates the existing collision object to match the components (applying forces).
-    void updateStateOfObject(shared_ptr<CollisionObject>& bodyComponent, CollisionObjectData& bodyData);
+    void updateStateOfObject(CollisionObject* bodyComponent, CollisionObjectData& bodyData);
 
     void addBody(CollisionObjectData& body);
     void removeBody(CollisionObjectData& body);
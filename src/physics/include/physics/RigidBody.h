@@ -18,6 +18,9 @@ public:
     void addTorque(const vec3& torque);
     void addTorqueImpulse(const vec3& torque);
 
+    // Also hashes the mass and, once the body is simulated, its velocities.
+    virtual void hashState(StateHasher& hasher) const override;
+
     virtual class btCollisionObject* constructObject(class btCollisionShape* shape,
         class btMotionState* motion) override;
 };
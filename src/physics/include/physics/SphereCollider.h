@@ -13,6 +13,7 @@ public:
     inline float getRadius() const { return radius; }
 
     virtual btCollisionShape* constructShape() override;
+    virtual void hashState(StateHasher& hasher) const override;
 protected:
-    float radius;
+    float radius = 1;
 };
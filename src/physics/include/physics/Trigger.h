@@ -13,8 +13,10 @@ public:
         class btMotionState* motion) override;
     
     vector<shared_ptr<CollisionObject>> getOverlaps();
+    // Returns the overlaps without resolving them. Some handles may refer to destroyed objects.
+    inline const vector<Handle<CollisionObject>>& getOverlapHandles() const { return overlaps; }
 private:
-    vector<weak_ptr<CollisionObject>> overlaps;
+    vector<Handle<CollisionObject>> overlaps;
 
     friend class PhysicsSystem;
 };
@@ -10,8 +10,15 @@ btCollisionShape* BoxCollider::constructShape()
     );
 }
 
+void BoxCollider::hashState(StateHasher& hasher) const
+{
+    Collider::hashState(hasher);
+    hasher.add(extents);
+}
+
 void BoxCollider::setExtents(const vec3& _extents)
 {
     extents = _extents;
     shapeUpdated = true;
+    markChanged();
 }
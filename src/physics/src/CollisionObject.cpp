@@ -1,37 +1,24 @@
 
 #include "physics/CollisionObject.h"
 
-vector<shared_ptr<Collider>> CollisionObject::getColliders()
+void CollisionObject::hashState(StateHasher& hasher) const
 {
-    vector<shared_ptr<Collider>> out;
-    out.reserve(colliders.size());
-    for(weak_ptr<Collider>& wptr : colliders) {
-        shared_ptr<Collider> collider = wptr.lock();
-        if(collider) {
-            out.push_back(collider);
-        }
+    Transformable::hashState(hasher);
+    hasher.add((uint64_t)colliders.size());
+    for(const Handle<Collider>& collider : colliders) {
+        Component::hashIdentity(hasher, collider.get());
     }
-    return out;
 }
 
-CollisionObject::Hit* CollisionObject::findHit(shared_ptr<CollisionObject> other)
+vector<Collider*> CollisionObject::getColliders() const
 {
-    for(Hit& hit : hits) {
-        if(hit.other.lock() == other) {
-            return &hit;
+    vector<Collider*> out;
+    out.reserve(colliders.size());
+    for(const Handle<Collider>& handle : colliders) {
+        Collider* collider = handle.get();
+        if(collider) {
+            out.push_back(collider);
         }
     }
-    return nullptr;
-}
-
-CollisionObject::Hit* CollisionObject::findOrCreateHit(shared_ptr<CollisionObject> other)
-{
-    Hit* hit = findHit(other);
-    if(!hit) {
-        Hit h;
-        h.other = other;
-        hits.push_back(h);
-        hit = &hits.back();
-    }
-    return hit;
+    return out;
 }
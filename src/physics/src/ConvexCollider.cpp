@@ -6,6 +6,13 @@ void ConvexCollider::setConvexHull(ResourceRef<ConvexHull> newHull)
     convexHull = newHull;
     convexHull.resolve(Deferred);
     shapeUpdated = true;
+    markChanged();
+}
+
+void ConvexCollider::hashState(StateHasher& hasher) const
+{
+    Collider::hashState(hasher);
+    hasher.add((uint)convexHull);
 }
 
 btCollisionShape* ConvexCollider::constructShape()
@@ -1,17 +1,23 @@
 
 #include "physics/PhysicsSystem.h"
 #include "core/World.h"
+#include "core/View.h"
+#include "core/Profiler.h"
 
 #include <bullet/btBulletDynamicsCommon.h>
 #include <bullet/BulletDynamics/Dynamics/btRigidBody.h>
 #include <bullet/BulletCollision/CollisionDispatch/btGhostObject.h>
 #include <bullet/BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
 #include "physics/Collider.h"
+#include "physics/BoxCollider.h"
+#include "physics/SphereCollider.h"
+#include "physics/ConvexCollider.h"
 #include "physics/CollisionObject.h"
 #include "physics/RigidBody.h"
 #include "physics/StaticBody.h"
 #include "physics/KinematicBody.h"
 #include "physics/Trigger.h"
+#include "physics/PhysicsEvents.h"
 
 #include "physics/BulletUtil.h"
 
@@ -20,36 +26,42 @@
 class TransformMotionState : public btMotionState
 {
 public:
-    weak_ptr<CollisionObject> target;
-    map<weak_ptr<CollisionObject>, PhysicsSystem::CollisionObjectData, owner_less<>>* collisionObjects;
+    Handle<CollisionObject> target;
+    map<Handle<CollisionObject>, PhysicsSystem::CollisionObjectData>* collisionObjects;
     btRigidBody* body = nullptr;
 
-    TransformMotionState(shared_ptr<CollisionObject> _target, 
-        map<weak_ptr<CollisionObject>,
-            PhysicsSystem::CollisionObjectData, owner_less<>>* _collisionObjects)
+    TransformMotionState(Handle<CollisionObject> _target,
+        map<Handle<CollisionObject>, PhysicsSystem::CollisionObjectData>* _collisionObjects)
         : target(_target), collisionObjects(_collisionObjects)
     { }
 
     virtual void getWorldTransform(btTransform& worldTransform) const override
     {
-        shared_ptr<CollisionObject> obj = target.lock();
-        shared_ptr<Transform> transform = obj->getTransform();
+        CollisionObject* obj = target.get();
+        Transform* transform = obj->getTransform();
         worldTransform = convert(transform ? transform->getGlobalTransform() : TransformData());
     }
 
     virtual void setWorldTransform(const btTransform& worldTransform) override
     {
-        shared_ptr<CollisionObject> obj = target.lock();
-        shared_ptr<Transform> transform = obj->getTransform();
+        CollisionObject* obj = target.get();
+        Transform* transform = obj->getTransform();
         if(transform) {
             TransformData td = convert(body ? body->getWorldTransform() : worldTransform);
             td.scale = transform->getGlobalTransform().scale;
             transform->setGlobalTransform(td);
-            collisionObjects->find(obj)->second.updateId = transform->sumUpdates();
+            collisionObjects->find(target)->second.version = transform->getWorldVersion();
         }
     }
 };
 
+PhysicsSystem::PhysicsSystem()
+{
+    declareAccess(
+        { get_id(BoxCollider), get_id(SphereCollider), get_id(ConvexCollider) },
+        { get_id(RigidBody), get_id(StaticBody), get_id(KinematicBody), get_id(Trigger), get_id(Transform) });
+}
+
 PhysicsSystem::~PhysicsSystem()
 {
     if(physicsWorld) { delete physicsWorld; }
@@ -84,96 +96,128 @@ void PhysicsSystem::init()
     triggerCallback = new btGhostPairCallback();
     physicsWorld->getPairCache()->setInternalGhostPairCallback(triggerCallback);
     physicsWorld->setGravity(convert(gravity));
+
+    bodies = getWorld()->addView({ get_id(RigidBody), get_id(StaticBody), get_id(KinematicBody), get_id(Trigger) });
 }
 
 void PhysicsSystem::gameplayTick(float delta)
 {
-    hash_set<shared_ptr<CollisionObject>> validBodies;
-    // Copy component data to bullet DSs.
-    for(auto it = collisionObjects.begin(); it != collisionObjects.end(); ) {
-        shared_ptr<CollisionObject> col = it->first.lock();
-        if(!col) {
-            reverseObjects.erase(it->second.collisionObject);
-            cleanUpCollisionObject(it->second);
-            collisionObjects.erase(it++);
-        } else {
-            validBodies.insert(col);
-            updateCollidersOfObject(col, it->second);
-            updateStateOfObject(col, it->second);
-            ++it;
+    {
+        PROFILE_SCOPE("PhysicsSystem::syncBodies");
+        // Tear down bodies that left the world since the last tick.
+        for(const Handle<Component>& removed : bodies->getRemoved()) {
+            Handle<CollisionObject> body = Handle<CollisionObject>::unchecked(removed);
+            auto it = collisionObjects.find(body);
+            if(it != collisionObjects.end()) {
+                reverseObjects.erase(it->second.collisionObject);
+                cleanUpCollisionObject(it->second);
+                collisionObjects.erase(it);
+            }
         }
-    }
-    hash_set<CollisionObject*> invalidBodies;
-    // Look through all body components and setup any new bodies.
-    Query<shared_ptr<CollisionObject>> allBodies = (
-        getWorld()->queryComponents(get_id(RigidBody))
-        | getWorld()->queryComponents(get_id(StaticBody))
-        | getWorld()->queryComponents(get_id(KinematicBody))
-        | getWorld()->queryComponents(get_id(Trigger))
-        )
-        .cast_ptr<CollisionObject>()
-        .filter([](shared_ptr<CollisionObject> ptr) {
-            return ptr->colliders.size() > 0;
-        });
-    for(shared_ptr<CollisionObject> body : allBodies) {
-        auto p = validBodies.insert(body);
-        if(!p.second) {
-            continue;
+        for(const Handle<Component>& added : bodies->getAdded()) {
+            pendingBodies.push_back(Handle<CollisionObject>::unchecked(added));
         }
-        setUpCollisionObject(body);
-    }
-
-    // Step the simulation one frame.
-    physicsWorld->stepSimulation(delta, 0);
-
-    // Go through all triggers we know about, clear their overlaps, and copy over their new overlaps.
-    for(auto& pair : collisionObjects) {
-        shared_ptr<CollisionObject> col = pair.first.lock();
-        if(!col || col->getTypeId() != get_id(Trigger)) {
-            continue;
+        bodies->clearChanges();
+
+        // Copy component data to bullet DSs.
+        for(auto it = collisionObjects.begin(); it != collisionObjects.end(); ) {
+            CollisionObject* col = it->first.get();
+            if(!col) {
+                reverseObjects.erase(it->second.collisionObject);
+                cleanUpCollisionObject(it->second);
+                collisionObjects.erase(it++);
+            } else {
+                if(collidersMayHaveChanged(col, it->second)) {
+                    updateCollidersOfObject(col, it->second);
+                }
+                updateStateOfObject(col, it->second);
+                ++it;
+            }
         }
-        shared_ptr<Trigger> trigger = static_pointer_cast<Trigger>(col);
-        btGhostObject* btTrigger = static_cast<btGhostObject*>(pair.second.collisionObject);
-        trigger->overlaps.clear();
-        int overlaps = btTrigger->getNumOverlappingObjects();
-        trigger->overlaps.reserve(overlaps);
-        for(int i = 0; i < overlaps; i++) {
-            auto jt = reverseObjects.find(btTrigger->getOverlappingObject(i));
-            if(jt == reverseObjects.end()) {
-                throw "Really not sure what heppened. Overlapped with an unknown collision object.";
+        // Set up new bodies once they have colliders. Bodies that left the world or are already set up are dropped.
+        for(auto it = pendingBodies.begin(); it != pendingBodies.end(); ) {
+            CollisionObject* body = it->get();
+            if(!body || !bodies->contains(body) || collisionObjects.count(*it)) {
+                it = pendingBodies.erase(it);
+            } else if(body->colliders.size() == 0) {
+                ++it;
+            } else {
+                setUpCollisionObject(body);
+                it = pendingBodies.erase(it);
             }
-            trigger->overlaps.push_back(jt->second);
         }
     }
 
-    int manifolds = dispatcher->getNumManifolds();
-    for(int i = 0; i < manifolds; i++) {
-        btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
-        const btCollisionObject* btObjectA = static_cast<const btCollisionObject*>(manifold->getBody0());
-        const btCollisionObject* btObjectB = static_cast<const btCollisionObject*>(manifold->getBody1());
+    {
+        PROFILE_SCOPE("PhysicsSystem::step");
+        // Step the simulation one frame.
+        physicsWorld->stepSimulation(delta, 0);
+    }
 
-        CollisionObject* objectA = static_cast<CollisionObject*>(btObjectA->getUserPointer());
-        CollisionObject* objectB = static_cast<CollisionObject*>(btObjectB->getUserPointer());
+    EventBus& events = getWorld()->getEventBus();
+    {
+        PROFILE_SCOPE("PhysicsSystem::updateTriggers");
+        // Go through all triggers we know about, replace their overlaps, and publish which overlaps started or ended.
+        for(auto& pair : collisionObjects) {
+            CollisionObject* col = pair.first.get();
+            if(!col || col->getTypeId() != get_id(Trigger)) {
+                continue;
+            }
+            Trigger* trigger = static_cast<Trigger*>(col);
+            Handle<Trigger> triggerHandle = Handle<Trigger>::unchecked(pair.first);
+            btGhostObject* btTrigger = static_cast<btGhostObject*>(pair.second.collisionObject);
+            previousOverlaps.swap(trigger->overlaps);
+            trigger->overlaps.clear();
+            int overlaps = btTrigger->getNumOverlappingObjects();
+            trigger->overlaps.reserve(overlaps);
+            for(int i = 0; i < overlaps; i++) {
+                auto jt = reverseObjects.find(btTrigger->getOverlappingObject(i));
+                if(jt == reverseObjects.end()) {
+                    throw "Really not sure what heppened. Overlapped with an unknown collision object.";
+                }
+                trigger->overlaps.push_back(jt->second);
+                if(find(previousOverlaps.begin(), previousOverlaps.end(), jt->second) == previousOverlaps.end()) {
+                    events.publish(TriggerEvent{ triggerHandle, jt->second, true });
+                }
+            }
+            for(const Handle<CollisionObject>& previous : previousOverlaps) {
+                if(find(trigger->overlaps.begin(), trigger->overlaps.end(), previous) == trigger->overlaps.end()) {
+                    events.publish(TriggerEvent{ triggerHandle, previous, false });
+                }
+            }
+        }
+    }
 
-        CollisionObject::Hit* hitA = objectA->findOrCreateHit(
-            static_pointer_cast<CollisionObject>(objectB->shared_from_this()));
-        CollisionObject::Hit* hitB = objectB->findOrCreateHit(
-            static_pointer_cast<CollisionObject>(objectA->shared_from_this()));
-        
-        int contacts = manifold->getNumContacts();
-        for(int j = 0; j < contacts; j++) {
-            const btManifoldPoint& contact = manifold->getContactPoint(j);
-
-            // TODO: Figure out how much force was applied by the contact.
-
-            hitA->contacts.push_back(CollisionObject::Contact(
-                convert(contact.getPositionWorldOnA()),
-                convert(contact.m_localPointA),
-                convert(contact.m_normalWorldOnB)));
-            hitB->contacts.push_back(CollisionObject::Contact(
-                convert(contact.getPositionWorldOnB()),
-                convert(contact.m_localPointB),
-                -convert(contact.m_normalWorldOnB)));
+    {
+        PROFILE_SCOPE("PhysicsSystem::publishContacts");
+        EventChannel<ContactEvent>& contactEvents = events.getChannel<ContactEvent>();
+        int manifolds = dispatcher->getNumManifolds();
+        for(int i = 0; i < manifolds; i++) {
+            btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+            const btCollisionObject* btObjectA = static_cast<const btCollisionObject*>(manifold->getBody0());
+            const btCollisionObject* btObjectB = static_cast<const btCollisionObject*>(manifold->getBody1());
+
+            Handle<CollisionObject> objectA(static_cast<CollisionObject*>(btObjectA->getUserPointer()));
+            Handle<CollisionObject> objectB(static_cast<CollisionObject*>(btObjectB->getUserPointer()));
+
+            int contacts = manifold->getNumContacts();
+            for(int j = 0; j < contacts; j++) {
+                const btManifoldPoint& contact = manifold->getContactPoint(j);
+
+                // TODO: Figure out how much force was applied by the contact.
+
+                ContactEvent pairEvents[2] = {
+                    { objectA, objectB, CollisionObject::Contact(
+                        convert(contact.getPositionWorldOnA()),
+                        convert(contact.m_localPointA),
+                        convert(contact.m_normalWorldOnB)) },
+                    { objectB, objectA, CollisionObject::Contact(
+                        convert(contact.getPositionWorldOnB()),
+                        convert(contact.m_localPointB),
+                        -convert(contact.m_normalWorldOnB)) },
+                };
+                contactEvents.publish(pairEvents, pairEvents + 2);
+            }
         }
     }
 }
@@ -191,28 +235,28 @@ void PhysicsSystem::cleanUpCollisionObject(PhysicsSystem::CollisionObjectData& b
     }
 }
 
-void PhysicsSystem::setUpCollisionObject(shared_ptr<CollisionObject>& bodyComponent)
+void PhysicsSystem::setUpCollisionObject(CollisionObject* bodyComponent)
 {
     CollisionObjectData data; 
     data.compoundShape = new btCompoundShape();
-    shared_ptr<Transform> bodyTransform = bodyComponent->getTransform();
-    for(shared_ptr<Collider>& collider : bodyComponent->getColliders())
+    Transform* bodyTransform = bodyComponent->getTransform();
+    for(Collider* collider : bodyComponent->getColliders())
     {
         btCollisionShape* shape = collider->constructShape();
-        shared_ptr<Transform> transform = collider->getTransform();
-        uint updateId = transform->sumUpdatesRelativeTo(bodyTransform);
+        Transform* transform = collider->getTransform();
+        uint64_t version = transform->getWorldVersion();
         if(shape) {
             TransformData td = transform->getTransformRelativeTo(bodyComponent->getTransform());
             shape->setLocalScaling(convert(td.scale));
             data.compoundShape->addChildShape(convert(td), shape);
         }
-        data.shapeMap.insert(make_pair(collider, make_pair(shape, updateId)));
+        data.shapeMap.insert(make_pair(Handle<Collider>(collider), make_pair(shape, version)));
         collider->shapeUpdated = false;
     }
     // No point in constructing the motion state if we won't use it.
     TransformMotionState* tms = bodyComponent->getTypeId() == get_id(Trigger) ? nullptr
         : new TransformMotionState(bodyComponent, &collisionObjects);
-    data.updateId = bodyTransform->sumUpdates();
+    data.version = bodyTransform->getWorldVersion();
     data.motionState = tms;
     TransformData bodyTD = bodyTransform->getGlobalTransform();
     data.compoundShape->setLocalScaling(convert(bodyTD.scale));
@@ -220,9 +264,8 @@ void PhysicsSystem::setUpCollisionObject(shared_ptr<CollisionObject>& bodyCompon
     if(bodyComponent->getTypeId() == get_id(Trigger)) {
         data.collisionObject->setWorldTransform(convert(bodyTD));
     }
-    data.collisionObject->setUserPointer(bodyComponent.get());
+    data.collisionObject->setUserPointer(bodyComponent);
     bodyComponent->body = data.collisionObject;
-    bodyComponent->hits.clear();
     btRigidBody* asRB = btRigidBody::upcast(data.collisionObject);
     if(tms) {
         tms->body = asRB;
@@ -234,8 +277,8 @@ void PhysicsSystem::setUpCollisionObject(shared_ptr<CollisionObject>& bodyCompon
     }
     addBody(data);
 
-    collisionObjects.insert(make_pair(bodyComponent, data));
-    reverseObjects.insert(make_pair(data.collisionObject, bodyComponent));
+    collisionObjects.insert(make_pair(Handle<CollisionObject>(bodyComponent), data));
+    reverseObjects.insert(make_pair(data.collisionObject, Handle<CollisionObject>(bodyComponent)));
 }
 
 hash_map<btCollisionShape*, int> getChildMap(btCompoundShape* shape)
@@ -249,30 +292,51 @@ hash_map<btCollisionShape*, int> getChildMap(btCompoundShape* shape)
     return childMap;
 }
 
-void PhysicsSystem::updateCollidersOfObject(shared_ptr<CollisionObject>& bodyComponent,
+bool PhysicsSystem::collidersMayHaveChanged(CollisionObject* bodyComponent,
+    const PhysicsSystem::CollisionObjectData& bodyData) const
+{
+    Transform* bodyTransform = bodyComponent->getTransform();
+    // Colliders changed in the last gameplay tick after this system ran have that tick, so compare inclusively.
+    uint lastSync = getLastGameplayTick();
+    size_t liveColliders = 0;
+    for(const Handle<Collider>& colliderHandle : bodyComponent->colliders) {
+        Collider* collider = colliderHandle.get();
+        if(!collider) {
+            continue;
+        }
+        liveColliders++;
+        auto it = bodyData.shapeMap.find(colliderHandle);
+        if(it == bodyData.shapeMap.end() || !it->second.first || collider->wasChangedSince(lastSync)
+            || collider->getTransform()->changedRelativeToSince(bodyTransform, it->second.second)) {
+            return true;
+        }
+    }
+    // Destroyed colliders still have shapes.
+    return liveColliders != bodyData.shapeMap.size();
+}
+
+void PhysicsSystem::updateCollidersOfObject(CollisionObject* bodyComponent,
     PhysicsSystem::CollisionObjectData& bodyData)
 {
-    shared_ptr<Transform> bodyTransform = bodyComponent->getTransform();
+    Transform* bodyTransform = bodyComponent->getTransform();
     hash_map<btCollisionShape*, int> childMap = getChildMap(bodyData.compoundShape);
     bool shapeUpdated = false;
-    hash_set<shared_ptr<Collider>> colliders;
+    hash_set<Handle<Collider>> colliders;
     // Go through each collider and ensure it exists and isn't updated.
-    for(shared_ptr<Collider>& collider : bodyComponent->getColliders()) {
-        if(!collider) {
-            continue;
-        }
-        colliders.insert(collider);
-        shared_ptr<Transform> transform = collider->getTransform();
-        auto it = bodyData.shapeMap.find(collider);
-        TransformData td = transform->getTransformRelativeTo(bodyComponent->getTransform());
-        uint updateId = transform->sumUpdatesRelativeTo(bodyTransform);
+    for(Collider* collider : bodyComponent->getColliders()) {
+        Handle<Collider> colliderHandle(collider);
+        colliders.insert(colliderHandle);
+        Transform* transform = collider->getTransform();
+        auto it = bodyData.shapeMap.find(colliderHandle);
 
-        // Check if this collider needs an update.
+        // Check if this collider needs an update. Moving the whole body does not move the collider within it.
         bool colliderUpdated = it == bodyData.shapeMap.end() || !it->second.first
-            || collider->shapeUpdated || it->second.second != updateId;
+            || collider->shapeUpdated || transform->changedRelativeToSince(bodyTransform, it->second.second);
         if(!colliderUpdated) { // Move on if it doesn't
             continue;
         }
+        TransformData td = transform->getTransformRelativeTo(bodyTransform);
+        uint64_t version = transform->getWorldVersion();
 
         // We need to handle the special case of the collision shape being null.
         // We only want to update the shape if the new shape is not null.
@@ -289,7 +353,7 @@ void PhysicsSystem::updateCollidersOfObject(shared_ptr<CollisionObject>& bodyCom
                 bodyData.compoundShape->addChildShape(convert(td), shape);
 
                 it->second.first = shape;
-                it->second.second = updateId;
+                it->second.second = version;
                 // Update the child map.
                 childMap = getChildMap(bodyData.compoundShape);
             }
@@ -309,10 +373,10 @@ void PhysicsSystem::updateCollidersOfObject(shared_ptr<CollisionObject>& bodyCom
                 bodyData.compoundShape->addChildShape(convert(td), shape);
             }
             if(it == bodyData.shapeMap.end()) {
-                bodyData.shapeMap.insert(make_pair(collider, make_pair(shape, updateId)));
+                bodyData.shapeMap.insert(make_pair(colliderHandle, make_pair(shape, version)));
             } else {
                 it->second.first = shape;
-                it->second.second = updateId;
+                it->second.second = version;
             }
             // Update the child map.
             childMap = getChildMap(bodyData.compoundShape);
@@ -326,7 +390,7 @@ void PhysicsSystem::updateCollidersOfObject(shared_ptr<CollisionObject>& bodyCom
                 bodyData.compoundShape->addChildShape(convert(td), shape);
             }
             it->second.first = shape;
-            it->second.second = updateId;
+            it->second.second = version;
             // Reset the updated flag.
             collider->shapeUpdated = false;
             // Update the child map.
@@ -335,16 +399,17 @@ void PhysicsSystem::updateCollidersOfObject(shared_ptr<CollisionObject>& bodyCom
             // This is if the transform was updated.
             bodyData.compoundShape->updateChildTransform(childMap[it->second.first], convert(td), false);
             it->second.first->setLocalScaling(convert(td.scale));
+            it->second.second = version;
         }
     }
     
-    set<weak_ptr<Collider>, owner_less<>> eraseTgts;
-    for(auto p : bodyData.shapeMap) {
-        if(colliders.find(p.first.lock()) == colliders.end()) {
-            eraseTgts.insert(p.first);
+    vector<Handle<Collider>> eraseTgts;
+    for(auto& p : bodyData.shapeMap) {
+        if(colliders.find(p.first) == colliders.end()) {
+            eraseTgts.push_back(p.first);
         }
     }
-    for(weak_ptr<Collider> collider : eraseTgts) {
+    for(Handle<Collider> collider : eraseTgts) {
         if(!shapeUpdated) {
             shapeUpdated = true;
             removeBody(bodyData);
@@ -364,16 +429,14 @@ void PhysicsSystem::updateCollidersOfObject(shared_ptr<CollisionObject>& bodyCom
     }
 }
 
-void PhysicsSystem::updateStateOfObject(shared_ptr<CollisionObject>& bodyComponent, CollisionObjectData& bodyData)
+void PhysicsSystem::updateStateOfObject(CollisionObject* bodyComponent, CollisionObjectData& bodyData)
 {
-    // Clear any hit info.
-    bodyComponent->hits.clear();
-
-    shared_ptr<Transform> transform = bodyComponent->getTransform();
-    if(transform->sumUpdates() == bodyData.updateId) {
+    Transform* transform = bodyComponent->getTransform();
+    if(transform->getWorldVersion() == bodyData.version) {
         return;
     }
-    TransformData globalTransform = transform->getGlobalTransform();
+    bodyData.version = transform->getWorldVersion();
+    const TransformData& globalTransform = transform->getGlobalTransform();
     bodyData.compoundShape->setLocalScaling(convert(globalTransform.scale));
     if(!(bodyData.collisionObject->getCollisionFlags() & btCollisionObject::CF_KINEMATIC_OBJECT))
     {
@@ -8,17 +8,37 @@
 #include "physics/ConvexHull.h"
 #include "physics/BulletUtil.h"
 
+// Returns true iff the collision object or its owner is in the ignored sets.
+static bool isIgnored(CollisionObject* CO,
+    const hash_set<shared_ptr<CollisionObject>>& ignoredBodies,
+    const hash_set<shared_ptr<Entity>>& ignoredEntities)
+{
+    if(!CO) {
+        return false;
+    }
+    // The ignored sets are keyed by shared_ptr, so only pay for the refcount when there is something to find.
+    if(!ignoredBodies.empty()
+        && ignoredBodies.find(static_pointer_cast<CollisionObject>(CO->shared_from_this())) != ignoredBodies.end()) {
+        return true;
+    }
+    if(ignoredEntities.empty()) {
+        return false;
+    }
+    shared_ptr<Entity> EN = CO->getOwner();
+    return EN && ignoredEntities.find(EN) != ignoredEntities.end();
+}
+
 struct FilterRaysCallback : public btCollisionWorld::RayResultCallback
 {
 public:
     btCollisionWorld::RayResultCallback* wrappedCallback;
-    const map<btCollisionObject*, weak_ptr<CollisionObject>>* reverseObjects;
+    const map<btCollisionObject*, Handle<CollisionObject>>* reverseObjects;
     bool hitTriggers;
     const hash_set<shared_ptr<CollisionObject>>* ignoredBodies;
     const hash_set<shared_ptr<Entity>>* ignoreEntities;
 
     FilterRaysCallback(btCollisionWorld::RayResultCallback* _wrappedCallback,
-        const map<btCollisionObject*, weak_ptr<CollisionObject>>* _reverseObjects)
+        const map<btCollisionObject*, Handle<CollisionObject>>* _reverseObjects)
         : wrappedCallback(_wrappedCallback), reverseObjects(_reverseObjects)
     {
         m_flags = wrappedCallback->m_flags;
@@ -37,11 +57,9 @@ public:
     virtual btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace) override
     {
         auto it = reverseObjects->find(const_cast<btCollisionObject*>(rayResult.m_collisionObject));
-        auto CO = it != reverseObjects->end() ? it->second.lock() : nullptr;
-        auto EN = CO ? CO->getOwner() : nullptr;
+        CollisionObject* CO = it != reverseObjects->end() ? it->second.get() : nullptr;
         if((!btGhostObject::upcast(rayResult.m_collisionObject) || hitTriggers)
-            && (!CO || ignoredBodies->find(CO) == ignoredBodies->end())
-            && (!EN || ignoreEntities->find(EN) == ignoreEntities->end())
+            && !isIgnored(CO, *ignoredBodies, *ignoreEntities)
         ) { // Do filtering.
             btScalar s = wrappedCallback->addSingleResult(rayResult, normalInWorldSpace);
             m_closestHitFraction = wrappedCallback->m_closestHitFraction;
@@ -72,7 +90,7 @@ RaycastHit PhysicsSystem::rayCast(const vec3& source, const vec3& direction, flo
     result.valid = false;
     result.point = source + direction * range;
     result.normal = vec3(0,0,0);
-    result.obj = shared_ptr<CollisionObject>();
+    result.obj = nullptr;
     result.fraction = 1;
 
     if(!physicsWorld) {
@@ -95,7 +113,7 @@ RaycastHit PhysicsSystem::rayCast(const vec3& source, const vec3& direction, flo
     if(closestRay.hasHit()) {
         result.valid = true;
         result.point = convert(closestRay.m_hitPointWorld);
-        result.obj = reverseObjects.find(const_cast<btCollisionObject*>(closestRay.m_collisionObject))->second.lock();
+        result.obj = reverseObjects.find(const_cast<btCollisionObject*>(closestRay.m_collisionObject))->second;
         result.normal = convert(closestRay.m_hitNormalWorld);
         result.fraction = closestRay.m_closestHitFraction;
     }
@@ -139,7 +157,7 @@ vector<RaycastHit> PhysicsSystem::rayCastAll(const vec3& source, const vec3& dir
         RaycastHit& result = hits[i];
         result.valid = true;
         result.point = convert(allRays.m_hitPointWorld[i]);
-        result.obj = reverseObjects.find(const_cast<btCollisionObject*>(allRays.m_collisionObjects[i]))->second.lock();
+        result.obj = reverseObjects.find(const_cast<btCollisionObject*>(allRays.m_collisionObjects[i]))->second;
         result.normal = convert(allRays.m_hitNormalWorld[i]);
         result.fraction = allRays.m_hitFractions[i];
     }
@@ -150,13 +168,13 @@ struct FilterConvexCallback : public btCollisionWorld::ConvexResultCallback
 {
 public:
     btCollisionWorld::ConvexResultCallback* wrappedCallback;
-    const map<btCollisionObject*, weak_ptr<CollisionObject>>* reverseObjects;
+    const map<btCollisionObject*, Handle<CollisionObject>>* reverseObjects;
     bool hitTriggers;
     const hash_set<shared_ptr<CollisionObject>>* ignoredBodies;
     const hash_set<shared_ptr<Entity>>* ignoreEntities;
 
     FilterConvexCallback(btCollisionWorld::ConvexResultCallback* _wrappedCallback,
-        const map<btCollisionObject*, weak_ptr<CollisionObject>>* _reverseObjects)
+        const map<btCollisionObject*, Handle<CollisionObject>>* _reverseObjects)
         : wrappedCallback(_wrappedCallback), reverseObjects(_reverseObjects)
     {
         m_collisionFilterMask = wrappedCallback->m_collisionFilterMask;
@@ -175,11 +193,9 @@ public:
         bool normalInWorldSpace) override
     {
         auto it = reverseObjects->find(const_cast<btCollisionObject*>(convexResult.m_hitCollisionObject));
-        auto CO = it != reverseObjects->end() ? it->second.lock() : nullptr;
-        auto EN = CO ? CO->getOwner() : nullptr;
+        CollisionObject* CO = it != reverseObjects->end() ? it->second.get() : nullptr;
         if((!btGhostObject::upcast(convexResult.m_hitCollisionObject) || hitTriggers)
-            && (!CO || ignoredBodies->find(CO) == ignoredBodies->end())
-            && (!EN || ignoreEntities->find(EN) == ignoreEntities->end())
+            && !isIgnored(CO, *ignoredBodies, *ignoreEntities)
         ) { // Do filtering.
             btScalar s = wrappedCallback->addSingleResult(convexResult, normalInWorldSpace);
             m_closestHitFraction = wrappedCallback->m_closestHitFraction;
@@ -241,7 +257,7 @@ RaycastHit PhysicsSystem::shapeCast(const class btConvexShape* shape,
     result.valid = false;
     result.point = targetPosition;
     result.normal = vec3(0,0,0);
-    result.obj = shared_ptr<CollisionObject>();
+    result.obj = nullptr;
     result.fraction = 1;
 
     if(!physicsWorld) {
@@ -264,7 +280,7 @@ RaycastHit PhysicsSystem::shapeCast(const class btConvexShape* shape,
         result.valid = true;
         result.point = convert(closestConvex.m_hitPointWorld);
         result.obj = reverseObjects.find(
-            const_cast<btCollisionObject*>(closestConvex.m_hitCollisionObject))->second.lock();
+            const_cast<btCollisionObject*>(closestConvex.m_hitCollisionObject))->second;
         result.normal = convert(closestConvex.m_hitNormalWorld);
         result.fraction = closestConvex.m_closestHitFraction;
     }
@@ -312,7 +328,7 @@ vector<RaycastHit> PhysicsSystem::shapeCastAll(const class btConvexShape* shape,
         result.valid = true;
         result.point = convert(allConvex.m_hitPointWorld[i]);
         result.obj = reverseObjects.find(
-            const_cast<btCollisionObject*>(allConvex.m_collisionObjects[i]))->second.lock();
+            const_cast<btCollisionObject*>(allConvex.m_collisionObjects[i]))->second;
         result.normal = convert(allConvex.m_hitNormalWorld[i]);
         result.fraction = allConvex.m_hitFractions[i];
     }
@@ -17,7 +17,7 @@ void RigidBody::addPointForce(const vec3& force, vec3 worldPoint)
 {
     if(getBody()) {
         btRigidBody* rbbody = static_cast<btRigidBody*>(getBody());
-        shared_ptr<Transform> transform = getTransform();
+        Transform* transform = getTransform();
         if(transform) {
             TransformData td = transform->getGlobalTransform();
             td.scale = vec3(1,1,1);
@@ -39,7 +39,7 @@ void RigidBody::addPointImpulse(const vec3& impulse, vec3 worldPoint)
 {
     if(getBody()) {
         btRigidBody* rbbody = static_cast<btRigidBody*>(getBody());
-        shared_ptr<Transform> transform = getTransform();
+        Transform* transform = getTransform();
         if(transform) {
             TransformData td = transform->getGlobalTransform();
             td.scale = vec3(1,1,1);
@@ -65,6 +65,15 @@ void RigidBody::addTorqueImpulse(const vec3& torque)
     }
 }
 
+void RigidBody::hashState(StateHasher& hasher) const
+{
+    CollisionObject::hashState(hasher);
+    hasher.add(mass);
+    const btRigidBody* rbbody = static_cast<const btRigidBody*>(getBody());
+    hasher.add(rbbody ? convert(rbbody->getLinearVelocity()) : vec3(0));
+    hasher.add(rbbody ? convert(rbbody->getAngularVelocity()) : vec3(0));
+}
+
 btCollisionObject* RigidBody::constructObject(btCollisionShape* shape, btMotionState* motion)
 {
     btVector3 inertia;
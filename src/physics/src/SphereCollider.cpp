@@ -8,8 +8,15 @@ btCollisionShape* SphereCollider::constructShape()
     return new btSphereShape(btScalar(radius));
 }
 
+void SphereCollider::hashState(StateHasher& hasher) const
+{
+    Collider::hashState(hasher);
+    hasher.add(radius);
+}
+
 void SphereCollider::setRadius(float _radius)
 {
     radius = _radius;
     shapeUpdated = true;
+    markChanged();
 }
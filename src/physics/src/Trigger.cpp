@@ -14,10 +14,11 @@ btCollisionObject* Trigger::constructObject(class btCollisionShape* shape, class
 vector<shared_ptr<CollisionObject>> Trigger::getOverlaps()
 {
     vector<shared_ptr<CollisionObject>> result;
-    for(weak_ptr<CollisionObject>& overlap : overlaps) {
-        shared_ptr<CollisionObject> overlapPtr = overlap.lock();
+    result.reserve(overlaps.size());
+    for(Handle<CollisionObject>& overlap : overlaps) {
+        CollisionObject* overlapPtr = overlap.get();
         if(overlapPtr) {
-            result.push_back(overlapPtr);
+            result.push_back(static_pointer_cast<CollisionObject>(overlapPtr->shared_from_this()));
         }
     }
     return result;
@@ -12,4 +12,7 @@ public:
 
     ResourceRef<RenderableMesh> mesh;
     ResourceRef<Material> material;
+
+    // Returns the model matrix of the renderer's transform (identity without one). Cached by the transform.
+    const mat4& getModelMatrix() const;
 };
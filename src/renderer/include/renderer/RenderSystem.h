@@ -11,6 +11,8 @@ class RenderSystem : public System
     virtual void init() override;
     virtual void frameTick(float delta) override;
 public:
+    RenderSystem();
+
     RenderSurface* targetSurface;
     bool swapBuffers = true;
 };
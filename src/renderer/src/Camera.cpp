@@ -13,7 +13,7 @@ mat4 Camera::getProjectionMatrix(float surfaceAspect) const
 
 mat4 Camera::getViewMatrix() const
 {
-    shared_ptr<Transform> t = getTransform();
+    Transform* t = getTransform();
     if(t) {
         TransformData td = t ? t->getGlobalTransform().inverse() : TransformData();
         return td.toMat4();
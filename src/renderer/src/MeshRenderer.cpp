@@ -0,0 +1,8 @@
+#include "renderer/MeshRenderer.h"
+
+const mat4& MeshRenderer::getModelMatrix() const
+{
+    static const mat4 identity(1.0f);
+    Transform* transform = getTransform();
+    return transform ? transform->getGlobalMatrix() : identity;
+}
@@ -52,7 +52,7 @@ public:
     ResourceRef(shared_ptr<T> _resource);
     ResourceRef(uint request);
 
-    operator uint() {
+    operator uint() const {
         return id;
     }
     
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "std.h"
+#include "core/Task.h"
+#include "resources/ResourceLoader.h"
+
+/*
+Suspends a task until the resource has finished loading, and returns it (or nullptr if it failed).
+Requests the resource with the Deferred method, so it is loaded by the next ResourceLoader::loadStep.
+*/
+template<typename T>
+class ResourceAwaiter
+{
+public:
+    ResourceAwaiter(ResourceRef<T> _ref) : ref(_ref) {}
+
+    inline bool await_ready() {
+        return isSettled();
+    }
+    inline void await_suspend(coroutine_handle<TaskPromise> handle) {
+        handle.promise().scheduler->waitUntil(handle.promise(), &ResourceAwaiter::poll, this);
+    }
+    inline shared_ptr<T> await_resume() {
+        return ref.resolve(Deferred);
+    }
+private:
+    inline bool isSettled() {
+        ref.resolve(Deferred);
+        ResourceState state = ref.getState();
+        return state != ResourceState::NotRequested && state != ResourceState::InProgress;
+    }
+    static bool poll(void* context) {
+        return static_cast<ResourceAwaiter*>(context)->isSettled();
+    }
+
+    ResourceRef<T> ref;
+};
+
+template<typename T>
+inline ResourceAwaiter<T> resource(ResourceRef<T> ref) {
+    return ResourceAwaiter<T>(ref);
+}
@@ -1,5 +1,6 @@
 
 #include "resources/ResourceLoader.h"
+#include "core/Profiler.h"
 
 #include <algorithm>
 
@@ -65,6 +66,7 @@ shared_ptr<Resource> ResourceLoader::buildResource(uint resourceId)
 
 void ResourceLoader::loadStep()
 {
+    PROFILE_SCOPE("ResourceLoader::loadStep");
     // Keep churning through requests until there are no more.
     while(!requests.empty()) {
         loadResource(requests.back().first);
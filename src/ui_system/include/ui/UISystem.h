@@ -13,6 +13,8 @@ class UISystem : public System
     virtual void init() override;
     virtual void frameTick(float delta) override;
 public:
+    UISystem();
+
     RenderSurface* targetSurface = nullptr;
     bool swapBuffers = true;
     float uiScale = 1.0f;
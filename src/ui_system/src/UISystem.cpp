@@ -4,6 +4,13 @@
 #define GLEW_STATIC
 #include <GL/glew.h>
 
+UISystem::UISystem()
+{
+    // UI draws with the GL context, and touches no components.
+    mainThreadOnly = true;
+    declareAccess({}, {});
+}
+
 void UISystem::init()
 {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);